@@ -0,0 +1,185 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Bisect Landlock's open latency regressions with "git bisect run".
+#
+# For each commit, build a light kernel (reusing a previous build of the same
+# source tree if any), boot it, and measure the Landlock overhead of open(2) at
+# a given path depth: the difference between a sandboxed and an unsandboxed
+# open-ntimes run.  The commit is good if the overhead is clearly below the
+# threshold, bad if it is clearly above, and measurements are retried when the
+# interquartile range straddles the threshold.  Commits that fail to build or
+# stay ambiguous are skipped.
+#
+# The same sandboxer binary is used for all commits: build it once (e.g. with
+# check-linux.sh build) and set SANDBOXER.
+#
+# cd linux
+# git bisect start <bad> <good>
+# SANDBOXER=.../sandboxer git bisect run .../bisect-perf.sh <threshold-ns> [depth]
+#
+# Optional environment variables:
+# - ROUNDS: number of measurements per boot (default: 5)
+# - ATTEMPTS: maximum number of boots before skipping (default: 3)
+# - NUM_ITERATIONS: open(2) calls per measurement (default: 100000)
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+DIRNAME="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+BASE_DIR="$(dirname -- "${DIRNAME}")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+# Exit codes understood by git bisect run.
+RET_GOOD=0
+RET_BAD=1
+RET_SKIP=125
+RET_ABORT=255
+
+ROUNDS="${ROUNDS:-5}"
+ATTEMPTS="${ATTEMPTS:-3}"
+NUM_ITERATIONS="${NUM_ITERATIONS:-100000}"
+
+# Runs inside the guest, from the bench directory.
+run_guest() {
+	local depth="$1"
+	local rounds="$2"
+	local num_iterations="$3"
+	local round ns_base ns_sandbox
+
+	for round in $(seq 1 "${rounds}"); do
+		ns_base="$(env IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh \
+			./open-ntimes "${num_iterations}" 0 "${depth}" \
+			| sed -n -e 's/^ns\/op: //p')"
+		ns_sandbox="$(env LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh \
+			./sandboxer ./open-ntimes "${num_iterations}" 0 "${depth}" \
+			| sed -n -e 's/^ns\/op: //p')"
+		echo "[bisect] round=${round} base=${ns_base} sandbox=${ns_sandbox}"
+	done
+}
+
+if [[ "${1:-}" == "--guest" ]]; then
+	shift
+	run_guest "$@"
+	exit 0
+fi
+
+if [[ $# -lt 1 ]] || [[ $# -gt 2 ]]; then
+	echo "usage: ${BASENAME} <threshold-ns> [depth]" >&2
+	exit "${RET_ABORT}"
+fi
+
+THRESHOLD="$1"
+DEPTH="${2:-/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9}"
+
+export ARCH="${ARCH:-um}"
+if [[ "${ARCH}" != "um" ]]; then
+	echo "ERROR: Architecture not supported" >&2
+	exit "${RET_ABORT}"
+fi
+
+CACHE_DIR="${XDG_CACHE_HOME:-${HOME}/.cache}/landlock-test-tools/bisect"
+WORK_DIR="${CACHE_DIR}/bench"
+SANDBOXER="${SANDBOXER:-./sandboxer}"
+
+if [[ ! -x "${SANDBOXER}" ]]; then
+	echo "ERROR: Missing sandboxer, see SANDBOXER: ${SANDBOXER}" >&2
+	exit "${RET_ABORT}"
+fi
+
+# The kernel must not be in /tmp nor /run (cf. uml-run.sh).
+mkdir -p -- "${WORK_DIR}"
+make -s -C "${DIRNAME}" open-ntimes
+cp -- "${DIRNAME}/open-ntimes" "${DIRNAME}/run-bench-in-namespace.sh" "${DIRNAME}/${BASENAME}" "${WORK_DIR}/"
+cp -- "${SANDBOXER}" "${WORK_DIR}/sandboxer"
+
+# Content cache: the same source tree and configuration give the same kernel.
+CACHE_KEY="$(git rev-parse HEAD^{tree})-$(cat -- "${BASE_DIR}/kernels/config-test" "${BASE_DIR}/kernels/config-mini-${ARCH}" | sha256sum | cut -c1-16)"
+KERNEL="${CACHE_DIR}/${CACHE_KEY}/linux"
+
+if [[ -x "${KERNEL}" ]]; then
+	echo "[*] Using cached kernel ${KERNEL}"
+else
+	export O="${O:-./.out-landlock_bisect-${ARCH}}"
+	if command -v ccache &>/dev/null; then
+		export CC="ccache ${CC:-gcc}"
+	fi
+	if ! "${BASE_DIR}/check-linux.sh" build_light; then
+		echo "[-] Build failed: skipping $(git rev-parse --short HEAD)"
+		exit "${RET_SKIP}"
+	fi
+	mkdir -p -- "${CACHE_DIR}/${CACHE_KEY}"
+	cp -- "${O}/linux" "${KERNEL}.tmp"
+	mv -- "${KERNEL}.tmp" "${KERNEL}"
+fi
+
+RESULTS="$(mktemp "--tmpdir=${CACHE_DIR}" .bisect-results.XXXXXXXXXX)"
+
+cleanup() {
+	rm -- "${RESULTS}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+# Prints good, bad or unknown according to the overhead interquartile range.
+decide() {
+	awk -v threshold="${THRESHOLD}" '
+	/^\[bisect\] / {
+		base = $3; sandbox = $4
+		sub(/^base=/, "", base)
+		sub(/^sandbox=/, "", sandbox)
+		if (base != "" && sandbox != "") {
+			v[n++] = sandbox - base
+		}
+	}
+	END {
+		if (n < 3) {
+			print "unknown"
+			exit
+		}
+		# Insertion sort, n is small.
+		for (i = 1; i < n; i++) {
+			x = v[i]
+			for (j = i - 1; j >= 0 && v[j] > x; j--) {
+				v[j + 1] = v[j]
+			}
+			v[j + 1] = x
+		}
+		q1 = v[int((n - 1) / 4)]
+		med = v[int((n - 1) / 2)]
+		q3 = v[int(3 * (n - 1) / 4 + 0.5)]
+		printf "[*] Overhead (ns): n=%d q1=%.1f median=%.1f q3=%.1f threshold=%s\n", n, q1, med, q3, threshold > "/dev/stderr"
+		if (q3 < threshold) {
+			print "good"
+		} else if (q1 > threshold) {
+			print "bad"
+		} else {
+			print "unknown"
+		}
+	}' "${RESULTS}"
+}
+
+for attempt in $(seq 1 "${ATTEMPTS}"); do
+	echo "[*] Measuring $(git rev-parse --short HEAD), attempt ${attempt}/${ATTEMPTS}"
+	(
+		cd "${WORK_DIR}"
+		timeout --signal KILL "$((ROUNDS * 60))" </dev/null 2>&1 "${BASE_DIR}/uml-run.sh" \
+			"${KERNEL}" \
+			-- \
+			"./${BASENAME}" --guest "${DEPTH}" "${ROUNDS}" "${NUM_ITERATIONS}" \
+			| timeout "$((ROUNDS * 60 + 1))" cat
+	) | tee -a "${RESULTS}" | grep '^\[bisect\] ' || :
+
+	case "$(decide)" in
+		good)
+			exit "${RET_GOOD}"
+			;;
+		bad)
+			exit "${RET_BAD}"
+			;;
+	esac
+done
+
+echo "[-] Too noisy: skipping $(git rev-parse --short HEAD)"
+exit "${RET_SKIP}"
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * calibrate [-n ntimes] [-b batches] <path>...
+ *
+ * Measure the costs that make up a sandboxed open(2) latency, to tell apart
+ * the share attributable to Landlock:
+ * - timer: one clock_gettime(2) call, subtracted from each batch;
+ * - syscall: a null system call (getppid), i.e. the syscall entry and exit
+ *   cost, which depends on the CPU mitigations;
+ * - open: an open(2) and close(2) of each path, without and with a Landlock
+ *   domain (from LL_FS_RO and LL_FS_RW, as for the sandboxer, and defaulting
+ *   to LL_FS_RO="/").
+ *
+ * Each cost is the mean of the batch means, and its error is the standard error
+ * of this mean (in percent, as for perf trace).  For each path, the Landlock
+ * delta is the sandboxed open latency minus the unsandboxed one, with an error
+ * combining both errors (in nanoseconds), and is also expressed as a number of
+ * null syscalls to compare hosts with different mitigations.
+ *
+ * Results are printed as "[calib]" lines, e.g. for results-db.sh:
+ * [calib] timer ns=20.1 err=0.12%
+ * [calib] syscall ns=85.3 err=0.20%
+ * [calib] open d=9 sandbox=0 ns=1021.4 err=0.31%
+ * [calib] open d=9 sandbox=1 ns=1322.8 err=0.28%
+ * [calib] delta d=9 ns=301.4 err=4.8 syscalls=3.53 share=22.8%
+ *
+ * LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./calibrate / /1/2/3/4/5/6/7/8/9/
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+#define MAX_PATHS 16
+#define MAX_BATCHES 100
+
+struct cost {
+	double ns;
+	/* Standard error of the mean, in nanoseconds. */
+	double err;
+};
+
+enum op {
+	OP_TIMER,
+	OP_SYSCALL,
+	OP_OPEN,
+};
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct cost summarize(const double *const means,
+			     const unsigned int batches)
+{
+	struct cost cost = {};
+	double var = 0;
+	unsigned int b;
+
+	for (b = 0; b < batches; b++)
+		cost.ns += means[b];
+	cost.ns /= batches;
+	for (b = 0; b < batches; b++)
+		var += (means[b] - cost.ns) * (means[b] - cost.ns);
+	if (batches > 1)
+		var /= batches - 1;
+	cost.err = sqrt(var / batches);
+	return cost;
+}
+
+/*
+ * Returns the cost of one operation, without the timer overhead.  A batch
+ * includes the end of its first clock_gettime call and the start of its last
+ * one, i.e. about one call, which is subtracted once per batch.
+ */
+static int measure(const enum op op, const char *const path,
+		   const unsigned int ntimes, const unsigned int batches,
+		   const double timer_ns, struct cost *const cost)
+{
+	const unsigned int per_batch = ntimes / batches;
+	double means[MAX_BATCHES];
+	unsigned long long start;
+	unsigned int b, i;
+	int fd;
+
+	for (b = 0; b < batches; b++) {
+		start = now_ns();
+		for (i = 0; i < per_batch; i++) {
+			switch (op) {
+			case OP_TIMER:
+				now_ns();
+				break;
+			case OP_SYSCALL:
+				syscall(SYS_getppid);
+				break;
+			case OP_OPEN:
+				fd = open(path, O_RDONLY | O_CLOEXEC);
+				if (fd < 0)
+					return -1;
+				close(fd);
+				break;
+			}
+		}
+		means[b] = ((double)(now_ns() - start) - timer_ns) / per_batch;
+	}
+	*cost = summarize(means, batches);
+	return 0;
+}
+
+/* Measures the opens in a child process, which may be sandboxed. */
+static int run(const bool sandboxed, char *const paths[],
+	       const unsigned int nb_paths, const unsigned int ntimes,
+	       const unsigned int batches, const double timer_ns,
+	       struct cost *const costs)
+{
+	const size_t size = sizeof(*costs) * nb_paths;
+	int pipefd[2], status;
+	unsigned int i;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		return -1;
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return -1;
+	}
+	if (!child) {
+		close(pipefd[0]);
+		if (sandboxed && ll_sandbox_from_env()) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		for (i = 0; i < nb_paths; i++) {
+			if (measure(OP_OPEN, paths[i], ntimes, batches,
+				    timer_ns, &costs[i])) {
+				fprintf(stderr, "Failed to open \"%s\": %s\n",
+					paths[i], strerror(errno));
+				_exit(1);
+			}
+		}
+		if (write(pipefd[1], costs, size) != size)
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], costs, size) == size;
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+/* Number of path components, as counted by results-db.sh. */
+static unsigned int depth(const char *const path)
+{
+	unsigned int n = 0;
+	const char *p;
+
+	for (p = path; *p; p++) {
+		if (*p != '/' && (p == path || p[-1] == '/'))
+			n++;
+	}
+	return n;
+}
+
+static double percent(const struct cost *const cost)
+{
+	return cost->ns ? 100 * cost->err / cost->ns : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int ntimes = 1000000, batches = 10, nb_paths, i;
+	struct cost timer, null_syscall, base[MAX_PATHS], sandbox[MAX_PATHS],
+		delta;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:b:")) != -1) {
+		switch (opt) {
+		case 'n':
+			ntimes = atoi(optarg);
+			break;
+		case 'b':
+			batches = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	nb_paths = argc - optind;
+	if (!nb_paths || nb_paths > MAX_PATHS || batches < 2 ||
+	    batches > MAX_BATCHES || ntimes < batches)
+		goto usage;
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+	if (!getenv("LL_FS_RO") && !getenv("LL_FS_RW"))
+		setenv("LL_FS_RO", "/", 1);
+
+	measure(OP_TIMER, NULL, ntimes, batches, 0, &timer);
+	printf("[calib] timer ns=%.1f err=%.2f%%\n", timer.ns, percent(&timer));
+	measure(OP_SYSCALL, NULL, ntimes, batches, timer.ns, &null_syscall);
+	printf("[calib] syscall ns=%.1f err=%.2f%%\n", null_syscall.ns,
+	       percent(&null_syscall));
+
+	if (run(false, argv + optind, nb_paths, ntimes, batches, timer.ns,
+		base) ||
+	    run(true, argv + optind, nb_paths, ntimes, batches, timer.ns,
+		sandbox))
+		return 1;
+
+	for (i = 0; i < nb_paths; i++) {
+		const unsigned int d = depth(argv[optind + i]);
+
+		printf("[calib] open d=%u sandbox=0 ns=%.1f err=%.2f%%\n", d,
+		       base[i].ns, percent(&base[i]));
+		printf("[calib] open d=%u sandbox=1 ns=%.1f err=%.2f%%\n", d,
+		       sandbox[i].ns, percent(&sandbox[i]));
+		delta.ns = sandbox[i].ns - base[i].ns;
+		delta.err = sqrt(base[i].err * base[i].err +
+				 sandbox[i].err * sandbox[i].err);
+		printf("[calib] delta d=%u ns=%.1f err=%.1f syscalls=%.2f share=%.1f%%\n",
+		       d, delta.ns, delta.err, delta.ns / null_syscall.ns,
+		       100 * delta.ns / sandbox[i].ns);
+	}
+	return 0;
+
+usage:
+	fprintf(stderr, "usage: %s [-n ntimes] [-b batches] <path>...\n",
+		argv[0]);
+	return 1;
+}
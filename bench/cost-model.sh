@@ -0,0 +1,310 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Fit a cost model of Landlock's open(2) overhead from cost-sweep measurements,
+# and use it to estimate the overhead of a policy on a set of paths.
+#
+# The model is linear:
+# overhead = intercept + walk * w + rules * r + layers * l + mounts * m
+# with walk the number of path components walked up from the file to the rule
+# granting access, rules the number of rules met during this walk, layers the
+# number of stacked domains, and mounts the number of mount points crossed.
+#
+# A model is only valid for the host and kernel it was fitted on.
+#
+# IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./cost-sweep /tmp | .../cost-model.sh fit > model
+# LL_FS_RO=/usr:/etc LL_FS_RW=/tmp .../cost-model.sh estimate model paths.list
+#
+# The policy is read from LL_FS_RO and LL_FS_RW (as for the sandboxer), or
+# from a POLICY file with one "ro <path>" or "rw <path>" line per rule.  The
+# path list has one absolute path per line, and duplicates weight the paths
+# accordingly (e.g. gen-tree output, or paths extracted from a workload).
+#
+# Optional environment variables for estimate:
+# - ACCESS: requested access, "read" or "write" (default: read)
+# - LAYERS: number of stacked domains (default: 1)
+# - MOUNTINFO: mount points to consider (default: /proc/self/mountinfo)
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+usage() {
+	echo "usage: ${BASENAME} fit < sweep-output > model" >&2
+	echo "usage: ${BASENAME} estimate <model> <path-list>" >&2
+	exit 1
+}
+
+# Least squares fit with the normal equations, ignoring constant features.
+fit() {
+	awk '
+	BEGIN {
+		nb_features = split("walk rules layers mounts", names)
+	}
+
+	$1 == "[sweep]" {
+		n++
+		for (i = 2; i <= NF; i++) {
+			split($i, kv, "=")
+			field[kv[1]] = kv[2]
+		}
+		x[n, 0] = 1
+		for (i = 1; i <= nb_features; i++) {
+			x[n, i] = field[names[i]]
+			if (x[n, i] != x[1, i]) {
+				varies[i] = 1
+			}
+		}
+		y[n] = field["sandbox"] - field["base"]
+	}
+
+	END {
+		if (n == 0) {
+			print "ERROR: No sweep result found" > "/dev/stderr"
+			exit 1
+		}
+
+		# Selected columns: the intercept and the varying features.
+		k = 0
+		col[k++] = 0
+		for (i = 1; i <= nb_features; i++) {
+			if (varies[i]) {
+				col[k++] = i
+			}
+		}
+		if (n < k) {
+			print "ERROR: Not enough sweep results" > "/dev/stderr"
+			exit 1
+		}
+
+		# Augmented matrix of the normal equations: [XtX | Xty]
+		for (i = 0; i < k; i++) {
+			for (j = 0; j < k; j++) {
+				a[i, j] = 0
+				for (s = 1; s <= n; s++) {
+					a[i, j] += x[s, col[i]] * x[s, col[j]]
+				}
+			}
+			a[i, k] = 0
+			for (s = 1; s <= n; s++) {
+				a[i, k] += x[s, col[i]] * y[s]
+			}
+		}
+
+		# Gauss-Jordan elimination with partial pivoting.
+		for (i = 0; i < k; i++) {
+			p = i
+			for (r = i + 1; r < k; r++) {
+				if ((a[r, i] < 0 ? -a[r, i] : a[r, i]) > (a[p, i] < 0 ? -a[p, i] : a[p, i])) {
+					p = r
+				}
+			}
+			if (a[p, i] == 0) {
+				print "ERROR: Singular system" > "/dev/stderr"
+				exit 1
+			}
+			for (j = 0; j <= k; j++) {
+				tmp = a[i, j]
+				a[i, j] = a[p, j]
+				a[p, j] = tmp
+			}
+			for (r = 0; r < k; r++) {
+				if (r == i) {
+					continue
+				}
+				f = a[r, i] / a[i, i]
+				for (j = i; j <= k; j++) {
+					a[r, j] -= f * a[i, j]
+				}
+			}
+		}
+		for (i = 0; i < k; i++) {
+			coef[col[i]] = a[i, k] / a[i, i]
+		}
+
+		# Coefficient of determination.
+		mean = 0
+		for (s = 1; s <= n; s++) {
+			mean += y[s] / n
+		}
+		ss_res = ss_tot = 0
+		for (s = 1; s <= n; s++) {
+			pred = 0
+			for (i = 0; i < k; i++) {
+				pred += coef[col[i]] * x[s, col[i]]
+			}
+			ss_res += (y[s] - pred) ^ 2
+			ss_tot += (y[s] - mean) ^ 2
+		}
+
+		printf("# samples: %d, R^2: %.3f\n", n, ss_tot ? 1 - ss_res / ss_tot : 0)
+		printf("intercept %.3f\n", coef[0])
+		for (i = 1; i <= nb_features; i++) {
+			if (!varies[i]) {
+				printf("# %s: not measured\n", names[i])
+			}
+			printf("%s %.3f\n", names[i], coef[i] + 0)
+		}
+	}'
+}
+
+# Prints the policy as "ro <path>" or "rw <path>" lines.
+policy() {
+	local path
+
+	if [[ -n "${POLICY:-}" ]]; then
+		grep -v -e '^\s*\(#\|$\)' -- "${POLICY}"
+		return
+	fi
+
+	local -a ro rw
+	IFS=: read -r -a ro <<< "${LL_FS_RO:-}"
+	IFS=: read -r -a rw <<< "${LL_FS_RW:-}"
+	for path in "${ro[@]}"; do
+		if [[ -n "${path}" ]]; then
+			echo "ro ${path}"
+		fi
+	done
+	for path in "${rw[@]}"; do
+		if [[ -n "${path}" ]]; then
+			echo "rw ${path}"
+		fi
+	done
+}
+
+estimate() {
+	local model="$1"
+	local paths="$2"
+	local access="${ACCESS:-read}"
+
+	if [[ "${access}" != "read" ]] && [[ "${access}" != "write" ]]; then
+		echo "ERROR: Invalid access: ${access}" >&2
+		exit 1
+	fi
+
+	# Inputs: the model, the policy, the mount points, and the paths.
+	awk -v access="${access}" -v layers="${LAYERS:-1}" '
+	function depth(path,    parts) {
+		return path == "/" ? 0 : split(path, parts, "/") - 1
+	}
+
+	# Removes duplicated and trailing slashes.
+	function normalize(path) {
+		gsub(/\/+/, "/", path)
+		if (path != "/") {
+			sub(/\/$/, "", path)
+		}
+		return path
+	}
+
+	function is_beneath(path, parent) {
+		return parent == "/" || path == parent || index(path, parent "/") == 1
+	}
+
+	FILENAME == ARGV[1] {
+		if (!/^#/) {
+			coef[$1] = $2
+		}
+		next
+	}
+
+	FILENAME == ARGV[2] {
+		rule = normalize(substr($0, 4))
+		nb_rules++
+		rules[nb_rules] = rule
+		grants[nb_rules] = ($1 == "rw" || access == "read")
+		next
+	}
+
+	# Mount points, from mountinfo.
+	FILENAME == ARGV[3] {
+		mnt = $5
+		gsub(/\\040/, " ", mnt)
+		mounts[normalize(mnt)] = 1
+		next
+	}
+
+	{
+		path = normalize($0)
+		if (!(path in count)) {
+			unique++
+		}
+		count[path]++
+		total++
+	}
+
+	END {
+		if (total == 0) {
+			print "ERROR: No path found" > "/dev/stderr"
+			exit 1
+		}
+
+		# Most expensive paths first.
+		top = "sort -g -r | head -n 20"
+		printf("%10s %6s %5s %5s %6s %-7s %s\n", "ns", "count", "walk", "rules", "mounts", "result", "path")
+		fflush()
+
+		for (path in count) {
+			d = depth(path)
+
+			# The deepest granting rule stops the walk.
+			cover = -1
+			for (r = 1; r <= nb_rules; r++) {
+				if (grants[r] && is_beneath(path, rules[r]) && depth(rules[r]) > cover) {
+					cover = depth(rules[r])
+				}
+			}
+			top_depth = cover < 0 ? 0 : cover
+			walk = d - top_depth
+
+			met = 0
+			for (r = 1; r <= nb_rules; r++) {
+				if (is_beneath(path, rules[r]) && depth(rules[r]) >= cover) {
+					met++
+				}
+			}
+
+			crossed = 0
+			for (mnt in mounts) {
+				if (is_beneath(path, mnt) && depth(mnt) > top_depth && depth(mnt) < d) {
+					crossed++
+				}
+			}
+
+			ns = coef["intercept"] + walk * coef["walk"] + met * coef["rules"] + layers * coef["layers"] + crossed * coef["mounts"]
+			sum += ns * count[path]
+			if (cover < 0) {
+				denied += count[path]
+			}
+			printf("%10.1f %6d %5d %5d %6d %-7s %s\n", ns, count[path], walk, met, crossed, cover < 0 ? "denied" : "allowed", path) | top
+		}
+		close(top)
+
+		printf("[*] %d paths (%d unique), %d denied\n", total, unique, denied)
+		printf("[*] Estimated %s overhead: %.1f ns per syscall on average\n", access, sum / total)
+	}' "${model}" <(policy) "${MOUNTINFO:-/proc/self/mountinfo}" "${paths}"
+}
+
+if [[ $# -lt 1 ]]; then
+	usage
+fi
+
+case "$1" in
+	fit)
+		if [[ $# -ne 1 ]]; then
+			usage
+		fi
+		fit
+		;;
+	estimate)
+		if [[ $# -ne 3 ]]; then
+			usage
+		fi
+		estimate "$2" "$3"
+		;;
+	*)
+		usage
+		;;
+esac
@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * cost-sweep [-n ntimes] [-w list] [-r list] [-l list] [-m list] <dir>
+ *
+ * Measure the Landlock overhead of open(2) for every combination of:
+ * - w: number of path components walked from the opened file up to the
+ *   directory with the rule granting access (default: 1,2,4,8,16,32);
+ * - r: number of rules met during this walk, including the granting one
+ *   (default: 1,2,4);
+ * - l: number of stacked domains (default: 1,2,4);
+ * - m: number of mount points crossed during this walk (default: 0,1,2).
+ *
+ * Each combination is measured in a child process, without and with
+ * sandbox, and printed as a "[sweep]" line for cost-model.sh.  Mount points are
+ * created with bind mounts in a private mount namespace, which requires
+ * CAP_SYS_ADMIN (e.g. in run-bench-in-namespace.sh).
+ *
+ * IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./cost-sweep /tmp | .../cost-model.sh fit > model
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+#define MAX_VALUES 16
+#define BATCHES 5
+
+struct values {
+	int v[MAX_VALUES];
+	unsigned int len;
+};
+
+struct config {
+	int walk;
+	int rules;
+	int layers;
+	int mounts;
+};
+
+/* Path of the opened file, and of its ancestors (ancestors[i] is i levels up). */
+static char file_path[PATH_MAX];
+static char ancestors[MAX_VALUES * 8][PATH_MAX];
+static int max_walk;
+
+static int parse_values(char *const str, struct values *const values)
+{
+	char *token, *saveptr = NULL, *list;
+
+	values->len = 0;
+	for (list = str; (token = strtok_r(list, ",", &saveptr)); list = NULL) {
+		if (values->len >= MAX_VALUES)
+			return -1;
+		values->v[values->len++] = atoi(token);
+	}
+	return values->len ? 0 : -1;
+}
+
+static int create_chain(const char *const dir)
+{
+	char path[PATH_MAX];
+	size_t len;
+	int i, fd;
+
+	if (max_walk >= (int)(sizeof(ancestors) / sizeof(ancestors[0]))) {
+		fprintf(stderr, "Walk too long\n");
+		return -1;
+	}
+
+	len = snprintf(path, sizeof(path), "%s/cost-sweep", dir);
+	if (mkdir(path, 0755) && errno != EEXIST)
+		return -1;
+	strcpy(ancestors[max_walk], path);
+
+	for (i = max_walk - 1; i > 0; i--) {
+		len += snprintf(path + len, sizeof(path) - len, "/%d", i);
+		if (len >= sizeof(path))
+			return -1;
+		if (mkdir(path, 0755) && errno != EEXIST)
+			return -1;
+		strcpy(ancestors[i], path);
+	}
+
+	if (snprintf(file_path, sizeof(file_path), "%s/file", path) >=
+	    sizeof(file_path))
+		return -1;
+	strcpy(ancestors[0], file_path);
+	fd = open(file_path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -1;
+	close(fd);
+	return 0;
+}
+
+/* Spreads n items over the levels [first, last]. */
+static int spread(const int i, const int n, const int first, const int last)
+{
+	return first + (long)i * (last - first + 1) / n;
+}
+
+/* Returns the mount ID of a path, from /proc/self/fdinfo. */
+static int get_mnt_id(const char *const path)
+{
+	char fdinfo[64], line[256];
+	int fd, mnt_id = -1;
+	FILE *f;
+
+	fd = open(path, O_PATH | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	snprintf(fdinfo, sizeof(fdinfo), "/proc/self/fdinfo/%d", fd);
+	f = fopen(fdinfo, "re");
+	if (f) {
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, "mnt_id: %d", &mnt_id) == 1)
+				break;
+		}
+		fclose(f);
+	}
+	close(fd);
+	return mnt_id;
+}
+
+/* Returns the number of mount points crossed from the file up to the rule. */
+static int count_crossings(const int walk)
+{
+	int i, crossings = 0, prev, cur;
+
+	prev = get_mnt_id(ancestors[0]);
+	if (prev < 0)
+		return -1;
+	for (i = 1; i <= walk; i++) {
+		cur = get_mnt_id(ancestors[i]);
+		if (cur < 0)
+			return -1;
+		if (cur != prev)
+			crossings++;
+		prev = cur;
+	}
+	return crossings;
+}
+
+static int add_mounts(const struct config *const config)
+{
+	int i, crossings;
+
+	if (!config->mounts)
+		return 0;
+
+	if (unshare(CLONE_NEWNS) ||
+	    mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL))
+		return -1;
+
+	/*
+	 * Mount points strictly between the file and the granting rule,
+	 * shallowest first: a (non-recursive) bind mount of an ancestor would
+	 * hide the mount points below it.
+	 */
+	for (i = config->mounts - 1; i >= 0; i--) {
+		const char *const path =
+			ancestors[spread(i, config->mounts, 1, config->walk - 1)];
+
+		if (mount(path, path, NULL, MS_BIND, NULL))
+			return -1;
+	}
+
+	crossings = count_crossings(config->walk);
+	if (crossings != config->mounts) {
+		fprintf(stderr, "Crossing %d mount points instead of %d\n",
+			crossings, config->mounts);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+static int sandbox(const struct config *const config)
+{
+	int layer, i;
+
+	for (layer = 0; layer < config->layers; layer++) {
+		const int ruleset_fd =
+			ll_create_ruleset(LL_ACCESS_FS_ROUGHLY_READ);
+		int err;
+
+		if (ruleset_fd < 0)
+			return -1;
+
+		/* The granting rule, at the end of the walk. */
+		err = ll_add_path(ruleset_fd, ancestors[config->walk],
+				  LL_ACCESS_FS_ROUGHLY_READ);
+
+		/*
+		 * Other rules met during the walk, which do not grant the
+		 * requested access and then do not stop the walk.
+		 */
+		for (i = 0; !err && i < config->rules - 1; i++)
+			err = ll_add_path(ruleset_fd,
+					  ancestors[spread(i, config->rules - 1,
+							   0, config->walk - 1)],
+					  LANDLOCK_ACCESS_FS_EXECUTE);
+
+		if (!err)
+			err = ll_restrict(ruleset_fd);
+		close(ruleset_fd);
+		if (err)
+			return -1;
+	}
+	return 0;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_double(const void *const a, const void *const b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Returns the median of the batch averages, in nanoseconds. */
+static double measure(const int ntimes)
+{
+	double batches[BATCHES];
+	int b, i, fd;
+
+	for (b = 0; b < BATCHES; b++) {
+		const unsigned long long start = now_ns();
+
+		for (i = 0; i < ntimes / BATCHES; i++) {
+			fd = open(file_path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return -1;
+			close(fd);
+		}
+		batches[b] = (double)(now_ns() - start) / (ntimes / BATCHES);
+	}
+	qsort(batches, BATCHES, sizeof(*batches), cmp_double);
+	return batches[BATCHES / 2];
+}
+
+static int run(const struct config *const config, const bool sandboxed,
+	       const int ntimes, double *const ns)
+{
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC))
+		return -1;
+
+	child = fork();
+	if (child < 0)
+		return -1;
+	if (!child) {
+		close(pipefd[0]);
+		if (add_mounts(config)) {
+			perror("Failed to create mount points");
+			_exit(1);
+		}
+		if (sandboxed && sandbox(config)) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		*ns = measure(ntimes);
+		if (*ns < 0) {
+			perror("Failed to open");
+			_exit(1);
+		}
+		if (write(pipefd[1], ns, sizeof(*ns)) != sizeof(*ns))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], ns, sizeof(*ns)) == sizeof(*ns);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+/* Measures all the rule and layer combinations for a walk and mount points. */
+static int sweep(struct config *const config, const struct values *const rules,
+		 const struct values *const layers, const int ntimes)
+{
+	unsigned int r, l;
+	double base, ns;
+
+	if (run(config, false, ntimes, &base))
+		return -1;
+
+	for (r = 0; r < rules->len; r++) {
+		for (l = 0; l < layers->len; l++) {
+			config->rules = rules->v[r];
+			config->layers = layers->v[l];
+
+			/* Other rules are on the file or inside the walk. */
+			if (config->rules < 1 ||
+			    config->rules - 1 > config->walk ||
+			    config->layers < 1)
+				continue;
+
+			if (run(config, true, ntimes, &ns))
+				return -1;
+
+			printf("[sweep] walk=%d rules=%d layers=%d mounts=%d base=%.1f sandbox=%.1f\n",
+			       config->walk, config->rules, config->layers,
+			       config->mounts, base, ns);
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct values walks = { { 1, 2, 4, 8, 16, 32 }, 6 };
+	struct values rules = { { 1, 2, 4 }, 3 };
+	struct values layers = { { 1, 2, 4 }, 3 };
+	struct values mounts = { { 0, 1, 2 }, 3 };
+	unsigned int w, m;
+	int opt, ntimes = 100000;
+	bool can_mount = true;
+
+	while ((opt = getopt(argc, argv, "n:w:r:l:m:")) != -1) {
+		switch (opt) {
+		case 'n':
+			ntimes = atoi(optarg);
+			break;
+		case 'w':
+			if (parse_values(optarg, &walks))
+				goto usage;
+			break;
+		case 'r':
+			if (parse_values(optarg, &rules))
+				goto usage;
+			break;
+		case 'l':
+			if (parse_values(optarg, &layers))
+				goto usage;
+			break;
+		case 'm':
+			if (parse_values(optarg, &mounts))
+				goto usage;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || ntimes < BATCHES)
+		goto usage;
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+
+	for (w = 0; w < walks.len; w++) {
+		if (walks.v[w] < 1)
+			goto usage;
+		if (walks.v[w] > max_walk)
+			max_walk = walks.v[w];
+	}
+	if (create_chain(argv[optind])) {
+		perror("Failed to create the directories");
+		return 1;
+	}
+
+	for (w = 0; w < walks.len; w++) {
+		for (m = 0; m < mounts.len; m++) {
+			struct config config = {
+				.walk = walks.v[w],
+				.mounts = mounts.v[m],
+			};
+
+			/* Mount points must be strictly inside the walk. */
+			if (config.mounts < 0 || config.mounts >= config.walk ||
+			    (config.mounts && !can_mount))
+				continue;
+
+			if (sweep(&config, &rules, &layers, ntimes)) {
+				if (!config.mounts)
+					return 1;
+				fprintf(stderr,
+					"Skipping mount crossings (requires CAP_SYS_ADMIN)\n");
+				can_mount = false;
+			}
+		}
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-n ntimes] [-w list] [-r list] [-l list] [-m list] <dir>\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,221 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Separate debug instrumentation overhead from Landlock's real cost.
+#
+# Build the current commit twice, as a release kernel (check-linux.sh
+# build_light) and as a debug kernel (check-linux.sh build, with config-check:
+# KASAN, lockdep, PROVE_RCU, kmemleak...), boot each one under UML, and run
+# the same measurements on both:
+# - the open(2) latency at several path depths, without and with sandbox;
+# - the duration of each Landlock selftest, if built (check-linux.sh
+#   build_kselftest).
+#
+# For each depth, the report shows the Landlock overhead (sandbox - base) on
+# both kernels, and the share of the debug overhead caused by the
+# instrumentation.  For each selftest, it shows the debug slowdown, and flags
+# the ones slowed down more than SLOW_RATIO times.
+#
+# cd linux
+# .../check-linux.sh build_kselftest
+# .../debug-overhead.sh
+#
+# Optional environment variables:
+# - ROUNDS: number of measurements per depth (default: 5)
+# - NUM_ITERATIONS: open(2) calls per measurement (default: 100000)
+# - SLOW_RATIO: selftest slowdown to flag (default: 3)
+# - TESTS_DIR: installed selftests (default: the check-linux.sh ones)
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+DIRNAME="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+BASE_DIR="$(dirname -- "${DIRNAME}")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+ROUNDS="${ROUNDS:-5}"
+NUM_ITERATIONS="${NUM_ITERATIONS:-100000}"
+SLOW_RATIO="${SLOW_RATIO:-3}"
+
+DEPTHS=(/ /1/2/3/4/5/6/7/8/9 /1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9)
+
+# Runs inside the guest, from the bench directory.
+run_guest() {
+	local rounds="$1"
+	local num_iterations="$2"
+	local tests_dir="$3"
+	shift 3
+	local depth round ns_base ns_sandbox test start end
+
+	for depth in "$@"; do
+		for round in $(seq 1 "${rounds}"); do
+			ns_base="$(env IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh \
+				./open-ntimes "${num_iterations}" 0 "${depth}" \
+				| sed -n -e 's/^ns\/op: //p')"
+			ns_sandbox="$(env LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh \
+				./sandboxer ./open-ntimes "${num_iterations}" 0 "${depth}" \
+				| sed -n -e 's/^ns\/op: //p')"
+			echo "[debug] depth=${depth} base=${ns_base} sandbox=${ns_sandbox}"
+		done
+	done
+
+	if [[ -z "${tests_dir}" ]]; then
+		return
+	fi
+
+	cd "${tests_dir}"
+	for test in $(ls -1 *_test | sort); do
+		start="$(date +%s.%N)"
+		if "./${test}" &>/dev/null; then
+			end="$(date +%s.%N)"
+			echo "[debug] test=${test} seconds=$(awk -v s="${start}" -v e="${end}" 'BEGIN { printf("%.3f", e - s) }')"
+		else
+			echo "[debug] test=${test} failed"
+		fi
+	done
+}
+
+if [[ "${1:-}" == "--guest" ]]; then
+	shift
+	run_guest "$@"
+	exit 0
+fi
+
+if [[ $# -ne 0 ]]; then
+	echo "usage: ${BASENAME}" >&2
+	exit 1
+fi
+
+export ARCH="${ARCH:-um}"
+if [[ "${ARCH}" != "um" ]]; then
+	echo "ERROR: Architecture not supported" >&2
+	exit 1
+fi
+
+CC="${CC:-gcc}"
+O_RELEASE="./.out-landlock_release-${ARCH}-${CC}"
+O_DEBUG="./.out-landlock_local-${ARCH}-${CC}"
+TESTS_DIR="${TESTS_DIR:-${O_DEBUG}/kselftest/kselftest_install/landlock}"
+
+if [[ -d "${TESTS_DIR}" ]]; then
+	TESTS_DIR="$(readlink -f -- "${TESTS_DIR}")"
+else
+	echo "[-] No selftests found, see TESTS_DIR: ${TESTS_DIR}"
+	TESTS_DIR=""
+fi
+
+# Both kernels are built from the same source tree; the debug one also
+# provides the sandboxer used for both.
+echo "[*] Building the debug kernel"
+O="${O_DEBUG}" "${BASE_DIR}/check-linux.sh" build
+echo "[*] Building the release kernel"
+O="${O_RELEASE}" "${BASE_DIR}/check-linux.sh" build_light
+
+# The kernels must not be in /tmp nor /run (cf. uml-run.sh).
+WORK_DIR="${XDG_CACHE_HOME:-${HOME}/.cache}/landlock-test-tools/debug-overhead"
+mkdir -p -- "${WORK_DIR}"
+make -s -C "${DIRNAME}" open-ntimes
+cp -- "${DIRNAME}/open-ntimes" "${DIRNAME}/run-bench-in-namespace.sh" "${DIRNAME}/${BASENAME}" "${WORK_DIR}/"
+cp -- "${O_DEBUG}/samples/landlock/sandboxer" "${WORK_DIR}/sandboxer"
+cp -- "${O_DEBUG}/linux" "${WORK_DIR}/linux-debug"
+cp -- "${O_RELEASE}/linux" "${WORK_DIR}/linux-release"
+
+RESULTS="$(mktemp "--tmpdir=${WORK_DIR}" .debug-results.XXXXXXXXXX)"
+
+cleanup() {
+	rm -- "${RESULTS}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+for variant in release debug; do
+	echo "[*] Measuring the ${variant} kernel"
+	(
+		cd "${WORK_DIR}"
+		"${BASE_DIR}/uml-run.sh" \
+			"./linux-${variant}" \
+			-- \
+			"./${BASENAME}" --guest "${ROUNDS}" "${NUM_ITERATIONS}" "${TESTS_DIR}" "${DEPTHS[@]}" \
+			</dev/null 2>&1
+	) | grep '^\[debug\] ' | sed -e "s/^\[debug\]/[debug] variant=${variant}/" | tee -a "${RESULTS}"
+done
+
+# Uses the median of each depth's overhead to ignore outliers.
+awk -v slow_ratio="${SLOW_RATIO}" '
+function median(key,    n, i, j, x, v) {
+	n = count[key]
+	for (i = 1; i <= n; i++) {
+		v[i] = values[key, i]
+	}
+	for (i = 2; i <= n; i++) {
+		x = v[i]
+		for (j = i - 1; j >= 1 && v[j] > x; j--) {
+			v[j + 1] = v[j]
+		}
+		v[j + 1] = x
+	}
+	return v[int((n + 1) / 2)]
+}
+
+{
+	for (i = 2; i <= NF; i++) {
+		split($i, kv, "=")
+		field[kv[1]] = kv[2]
+	}
+	variant = field["variant"]
+}
+
+$3 ~ /^depth=/ && field["base"] != "" && field["sandbox"] != "" {
+	depth = field["depth"]
+	if (!(depth in seen)) {
+		seen[depth] = 1
+		depths[++nb_depths] = depth
+	}
+	key = variant SUBSEP depth
+	n = ++count[key, "base"]
+	values[key, "base", n] = field["base"]
+	values[key, "overhead", n] = field["sandbox"] - field["base"]
+	count[key, "overhead"] = n
+	delete field
+	next
+}
+
+$3 ~ /^test=/ {
+	test = field["test"]
+	if (!(test in tseen)) {
+		tseen[test] = 1
+		tests[++nb_tests] = test
+	}
+	seconds[variant, test] = NF == 4 && $4 == "failed" ? "failed" : field["seconds"]
+	delete field
+}
+
+END {
+	printf("\n%-40s %10s %10s %10s %10s %8s\n", "depth", "rel base", "rel cost", "dbg base", "dbg cost", "debug%")
+	for (i = 1; i <= nb_depths; i++) {
+		depth = depths[i]
+		if (!(("release", depth, "base") in count) || !(("debug", depth, "base") in count)) {
+			continue
+		}
+		rel_base = median("release" SUBSEP depth SUBSEP "base")
+		rel_cost = median("release" SUBSEP depth SUBSEP "overhead")
+		dbg_base = median("debug" SUBSEP depth SUBSEP "base")
+		dbg_cost = median("debug" SUBSEP depth SUBSEP "overhead")
+		printf("%-40s %10.1f %10.1f %10.1f %10.1f %7.1f%%\n", depth, rel_base, rel_cost, dbg_base, dbg_cost, dbg_cost > 0 ? 100 * (dbg_cost - rel_cost) / dbg_cost : 0)
+	}
+
+	if (nb_tests) {
+		printf("\n%-40s %10s %10s %8s\n", "selftest", "rel (s)", "dbg (s)", "slowdown")
+	}
+	for (i = 1; i <= nb_tests; i++) {
+		test = tests[i]
+		rel = seconds["release", test]
+		dbg = seconds["debug", test]
+		if (rel == "failed" || dbg == "failed" || rel == "" || dbg == "" || rel <= 0) {
+			printf("%-40s %10s %10s %8s\n", test, rel == "" ? "-" : rel, dbg == "" ? "-" : dbg, "-")
+			continue
+		}
+		printf("%-40s %10.3f %10.3f %7.1fx%s\n", test, rel, dbg, dbg / rel, dbg / rel > slow_ratio ? " (debug)" : "")
+	}
+}' "${RESULTS}"
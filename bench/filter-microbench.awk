@@ -12,6 +12,21 @@ $1 == "[*]" {
 	print
 }
 
+# Run metadata, cf. results-db.sh
+$1 == "[meta]" {
+	print
+}
+
+# ftrace-landlock.sh output
+$1 == "[ftrace]" {
+	print
+}
+
+# calibrate output
+$1 == "[calib]" {
+	print
+}
+
 # perf output:
 #
 # Summary of events:
@@ -0,0 +1,169 @@
+#!/usr/bin/env -S awk -f
+# SPDX-License-Identifier: GPL-2.0
+#
+# Render folded stacks as an SVG flame graph.
+#
+# Input lines, sorted by stack:
+#   <frame;frame;...> <count>
+#   <frame;frame;...> <count-before> <count-after>
+#
+# With two counts, frame widths are the "after" counts and frames are colored
+# according to their difference: red if more samples, blue if less.
+#
+# LC_ALL=C sort -k1,1 diff.folded | .../flamegraph.awk -v title="..." > diff.svg
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+function xml(s) {
+	gsub(/&/, "\\&amp;", s)
+	gsub(/</, "\\&lt;", s)
+	gsub(/>/, "\\&gt;", s)
+	gsub(/"/, "\\&quot;", s)
+	return s
+}
+
+# Records the frame at depth d, which ends at the current position.
+function close_frame(d) {
+	if (x > start[d]) {
+		nodes++
+		node_name[nodes] = name[d]
+		node_depth[nodes] = d
+		node_start[nodes] = start[d]
+		node_width[nodes] = x - start[d]
+		node_delta[nodes] = delta[d]
+		if (d > max_depth) {
+			max_depth = d
+		}
+		if (delta[d] > max_delta) {
+			max_delta = delta[d]
+		}
+		if (-delta[d] > max_delta) {
+			max_delta = -delta[d]
+		}
+	}
+}
+
+function hash(s,    i, h) {
+	h = 0
+	for (i = 1; i <= length(s) && i <= 8; i++) {
+		h = (h * 31 + index("abcdefghijklmnopqrstuvwxyz_", substr(s, i, 1))) % 1000
+	}
+	return h / 1000
+}
+
+function color(i,    v, r, g, b) {
+	if (diff) {
+		if (max_delta == 0) {
+			return "rgb(250,250,250)"
+		}
+		v = int(200 * node_delta[i] / max_delta)
+		if (v > 0) {
+			return sprintf("rgb(250,%d,%d)", 250 - v, 250 - v)
+		}
+		return sprintf("rgb(%d,%d,250)", 250 + v, 250 + v)
+	}
+	# Warm palette, stable for a given name.
+	v = hash(node_name[i])
+	r = 205 + int(50 * v)
+	g = int(230 * v)
+	b = int(55 * (1 - v))
+	return sprintf("rgb(%d,%d,%d)", r, g, b)
+}
+
+BEGIN {
+	if (title == "") {
+		title = "Flame Graph"
+	}
+	if (width == "") {
+		width = 1200
+	}
+	frame_height = 16
+	pad_top = 40
+	pad_bottom = 10
+	pad_side = 10
+	font_width = 0.59 * 12
+	diff = 0
+	x = 0
+	depth = 0
+	nodes = 0
+	max_depth = 0
+	max_delta = 0
+	name[0] = "all"
+	start[0] = 0
+	delta[0] = 0
+}
+
+NF >= 2 {
+	if (NF >= 3) {
+		diff = 1
+		before = $(NF - 1)
+		count = $NF
+	} else {
+		before = $NF
+		count = $NF
+	}
+	n = split($1, frames, ";")
+
+	# Finds the common prefix with the previous stack.
+	common = 0
+	while (common < depth && common < n && name[common + 1] == frames[common + 1]) {
+		common++
+	}
+	for (d = depth; d > common; d--) {
+		close_frame(d)
+	}
+	for (d = common + 1; d <= n; d++) {
+		name[d] = frames[d]
+		start[d] = x
+		delta[d] = 0
+	}
+	depth = n
+
+	x += count
+	for (d = 0; d <= depth; d++) {
+		delta[d] += count - before
+	}
+}
+
+END {
+	for (d = depth; d >= 0; d--) {
+		close_frame(d)
+	}
+	total = x
+	if (total == 0) {
+		total = 1
+	}
+	height = (max_depth + 1) * frame_height + pad_top + pad_bottom
+	scale = (width - 2 * pad_side) / total
+
+	printf "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+	printf "<svg version=\"1.1\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\" xmlns=\"http://www.w3.org/2000/svg\">\n", width, height, width, height
+	printf "<rect x=\"0\" y=\"0\" width=\"100%%\" height=\"100%%\" fill=\"rgb(248,248,248)\"/>\n"
+	printf "<text x=\"%d\" y=\"24\" text-anchor=\"middle\" font-family=\"Verdana\" font-size=\"17\">%s</text>\n", width / 2, xml(title)
+	printf "<g font-family=\"Verdana\" font-size=\"12\">\n"
+	for (i = 1; i <= nodes; i++) {
+		w = node_width[i] * scale
+		if (w < 0.1) {
+			continue
+		}
+		fx = pad_side + node_start[i] * scale
+		fy = height - pad_bottom - (node_depth[i] + 1) * frame_height
+		info = sprintf("%s (%d samples, %.2f%%", node_name[i], node_width[i], 100 * node_width[i] / total)
+		if (diff) {
+			info = info sprintf(", %+d", node_delta[i])
+		}
+		info = info ")"
+		printf "<g><title>%s</title>", xml(info)
+		printf "<rect x=\"%.1f\" y=\"%d\" width=\"%.1f\" height=\"%d\" fill=\"%s\" rx=\"2\" ry=\"2\"/>", fx, fy, w, frame_height - 1, color(i)
+		chars = int((w - 6) / font_width)
+		if (chars >= 3) {
+			label = node_name[i]
+			if (length(label) > chars) {
+				label = substr(label, 1, chars - 2) ".."
+			}
+			printf "<text x=\"%.1f\" y=\"%d\">%s</text>", fx + 3, fy + 12, xml(label)
+		}
+		printf "</g>\n"
+	}
+	printf "</g>\n</svg>\n"
+}
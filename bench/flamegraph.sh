@@ -0,0 +1,85 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run the open benchmarks with perf sampling, and render flame graphs of the
+# sandboxed and unsandboxed runs, plus a differential one (sandboxed minus
+# unsandboxed) for each path depth.  Everything is rendered locally.
+#
+# cd linux
+# ARCH=x86_64 .../check-linux.sh build_light
+# # Run a VM with this new kernel
+# .../flamegraph.sh vm0
+# firefox flamegraphs/diff-d29.svg
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+DIRNAME="$(dirname -- "${BASH_SOURCE[0]}")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+if [[ $# -gt 1 ]]; then
+	echo "usage: ${BASENAME} [ssh-host]" >&2
+	exit 1
+fi
+
+OUT_DIR="${FLAMEGRAPH_DIR:-./flamegraphs}"
+mkdir -p -- "${OUT_DIR}"
+rm -f -- "${OUT_DIR}"/*.folded
+
+# Splits the folded stacks according to the sandbox mode and the path depth.
+PROFILE=flamegraph "${DIRNAME}/microbench.sh" "$@" | awk -v out="${OUT_DIR}" '
+$1 == "[*]" {
+	print
+	mode = ($2 == "with") ? "sandbox" : "base"
+	d = $NF
+	sub(/^d=/, "", d)
+	gsub(/\/+$/, "", d)
+	depth = gsub(/\//, "", d)
+	file = out "/" mode "-d" depth ".folded"
+}
+
+$1 == "[folded]" {
+	print $2, $3 > file
+}'
+
+render() {
+	local folded="$1"
+	local title="$2"
+
+	LC_ALL=C sort -k1,1 -- "${folded}" | awk -f "${DIRNAME}/flamegraph.awk" -v title="${title}" > "${folded%.folded}.svg"
+	echo "[+] ${folded%.folded}.svg"
+}
+
+for base in "${OUT_DIR}"/base-d*.folded; do
+	if [[ ! -f "${base}" ]]; then
+		echo "ERROR: No profile found" >&2
+		exit 1
+	fi
+	depth="${base##*/base-}"
+	depth="${depth%.folded}"
+	sandbox="${OUT_DIR}/sandbox-${depth}.folded"
+
+	render "${base}" "open without sandbox, ${depth}"
+	if [[ ! -f "${sandbox}" ]]; then
+		continue
+	fi
+	render "${sandbox}" "open with sandbox, ${depth}"
+
+	# Stacks are rooted at the command name, which is the same in both runs.
+	awk '
+	NR == FNR {
+		before[$1] = $2
+		next
+	}
+	{
+		print $1, before[$1] + 0, $2
+		delete before[$1]
+	}
+	END {
+		for (stack in before) {
+			print stack, before[stack], 0
+		}
+	}' "${base}" "${sandbox}" > "${OUT_DIR}/diff-${depth}.folded"
+	render "${OUT_DIR}/diff-${depth}.folded" "open with sandbox minus without sandbox, ${depth} (red: more samples)"
+done
@@ -0,0 +1,187 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run a command while tracing Landlock functions with the function_graph
+# tracer, and print their number of calls, total and self time.
+#
+# Only the calls made from a Landlock hook (FTRACE_ROOTS) by the command and
+# its children are traced.  The self time of a function excludes the time spent
+# in the other traced functions (FTRACE_FUNCS), e.g. the self time of
+# is_access_to_paths_allowed() is the dentry walk without the rule lookups.
+# Functions that are inlined or don't exist in the running kernel are ignored.
+#
+# The trace is streamed and summarized on the fly, which makes it possible to
+# profile long benchmarks.  Tracing slows down the traced functions, so only
+# compare the relative costs.
+#
+# ./ftrace-landlock.sh ./sandboxer ./open-ntimes 100000 0 /1/2/3/4/5/6/7/8/9
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -u -e -o pipefail
+
+if [[ $# -lt 1 ]]; then
+	echo "usage: $(basename -- "${BASH_SOURCE[0]}") <command> [arg]..." >&2
+	exit 1
+fi
+
+# Landlock hooks from which the call graphs are traced.
+FTRACE_ROOTS="${FTRACE_ROOTS:-hook_file_open hook_file_truncate hook_path_truncate}"
+
+# Functions traced in these call graphs: Landlock helpers and the VFS
+# functions used by the path walk.
+FTRACE_FUNCS="${FTRACE_FUNCS:-landlock_* current_check_access_path check_access_path is_access_to_paths_allowed find_rule unmask_layers init_layer_masks get_current_fs_domain get_handled_fs_accesses collect_domain_accesses may_refer is_nouser_or_private follow_up dget_parent dput path_get path_put}"
+
+TRACING="/sys/kernel/tracing"
+if [[ ! -f "${TRACING}/tracing_on" ]]; then
+	TRACING="/sys/kernel/debug/tracing"
+fi
+if [[ ! -f "${TRACING}/tracing_on" ]]; then
+	echo "ERROR: Tracefs is not available (see CONFIG_FTRACE)" >&2
+	exit 1
+fi
+if ! grep -qw function_graph "${TRACING}/available_tracers"; then
+	echo "ERROR: The function_graph tracer is not available (see CONFIG_FUNCTION_GRAPH_TRACER)" >&2
+	exit 1
+fi
+if [[ ! -f "${TRACING}/available_filter_functions" ]]; then
+	echo "ERROR: Function filters are not available (see CONFIG_DYNAMIC_FTRACE)" >&2
+	exit 1
+fi
+
+TMP_DIR="$(mktemp -d -p . .ftrace-landlock.XXXXXXXXXX)"
+FIFO="${TMP_DIR}/fifo"
+SUMMARY="${TMP_DIR}/summary"
+CAT_PID=""
+
+cleanup() {
+	echo 0 > "${TRACING}/tracing_on"
+	echo nop > "${TRACING}/current_tracer"
+	echo > "${TRACING}/set_graph_function"
+	echo > "${TRACING}/set_ftrace_filter"
+	echo > "${TRACING}/set_ftrace_pid"
+	if [[ -n "${CAT_PID}" ]]; then
+		kill "${CAT_PID}" 2>/dev/null || :
+	fi
+	rm -r -- "${TMP_DIR}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+# Only keeps the functions available for tracing (e.g. not inlined).
+set_functions() {
+	local file="$1"
+	local name
+	shift
+
+	echo > "${file}"
+	for name in "$@"; do
+		if [[ "${name}" == *"*"* ]]; then
+			echo "${name}" >> "${file}" 2>/dev/null || :
+		elif cut -d' ' -f1 "${TRACING}/available_filter_functions" | grep -qFx -- "${name}"; then
+			echo "${name}" >> "${file}"
+		fi
+	done
+}
+
+echo 0 > "${TRACING}/tracing_on"
+echo nop > "${TRACING}/current_tracer"
+echo > "${TRACING}/trace"
+
+set_functions "${TRACING}/set_graph_function" ${FTRACE_ROOTS}
+set_functions "${TRACING}/set_ftrace_filter" ${FTRACE_ROOTS} ${FTRACE_FUNCS}
+
+if [[ -z "$(grep -v '^#' "${TRACING}/set_graph_function")" ]]; then
+	echo "ERROR: None of these Landlock hooks can be traced: ${FTRACE_ROOTS}" >&2
+	exit 1
+fi
+
+echo "[*] ftrace functions: $(grep -v '^#' "${TRACING}/set_ftrace_filter" | tr '\n' ' ')"
+
+echo function_graph > "${TRACING}/current_tracer"
+echo 1 > "${TRACING}/options/funcgraph-tail"
+echo 0 > "${TRACING}/options/funcgraph-overhead"
+echo 1 > "${TRACING}/options/function-fork"
+echo 8192 > "${TRACING}/buffer_size_kb"
+
+# function_graph output:
+#
+#  1)               |  hook_file_open() {
+#  1)   0.210 us    |    landlock_get_applicable_subject();
+#  1)               |    is_access_to_paths_allowed() {
+#  1)   0.120 us    |      dget_parent();
+#  1)   1.834 us    |    } /* is_access_to_paths_allowed */
+#  1)   2.915 us    |  } /* hook_file_open */
+mkfifo "${FIFO}"
+awk '
+function add(cpu, name, dur) {
+	calls[name]++
+	total[name] += dur
+	self[name] += dur - children[cpu, depth[cpu] + 1]
+	children[cpu, depth[cpu]] += dur
+}
+
+/\|/ {
+	split($0, side, "|")
+	cpu = side[1]
+	sub(/\).*/, "", cpu)
+	gsub(/[ \t]/, "", cpu)
+	dur = side[1]
+	sub(/^[^)]*\)/, "", dur)
+	gsub(/[^0-9.]/, "", dur)
+	code = side[2]
+	sub(/^[ \t]+/, "", code)
+	sub(/[ \t]+$/, "", code)
+
+	if (code ~ /\(\) \{$/) {
+		depth[cpu]++
+		children[cpu, depth[cpu]] = 0
+	} else if (code ~ /\(\);$/) {
+		name = code
+		sub(/\(.*/, "", name)
+		children[cpu, depth[cpu] + 1] = 0
+		add(cpu, name, dur)
+	} else if (code ~ /^\} \/\* .* \*\/$/) {
+		name = code
+		sub(/^\} \/\* /, "", name)
+		sub(/ \*\/$/, "", name)
+		depth[cpu]--
+		if (depth[cpu] < 0) {
+			# Missed the function entry.
+			depth[cpu] = 0
+			next
+		}
+		add(cpu, name, dur)
+	}
+}
+
+END {
+	sort = "sort -k4 -n -r"
+	printf "[ftrace] %-32s %10s %12s %12s %10s %10s\n", "function", "calls", "total(us)", "self(us)", "total/call", "self/call"
+	fflush()
+	for (name in calls) {
+		printf "[ftrace] %-32s %10d %12.1f %12.1f %10.3f %10.3f\n", name, calls[name], total[name], self[name], total[name] / calls[name], self[name] / calls[name] | sort
+	}
+	close(sort)
+}' < "${FIFO}" > "${SUMMARY}" &
+AWK_PID=$!
+
+cat "${TRACING}/trace_pipe" > "${FIFO}" &
+CAT_PID=$!
+
+# Only traces the command, not the trace readers.
+echo "$$" > "${TRACING}/set_ftrace_pid"
+echo 1 > "${TRACING}/tracing_on"
+RET=0
+"$@" || RET=$?
+echo 0 > "${TRACING}/tracing_on"
+
+# Lets the reader drain the trace buffer.
+sleep 1
+kill "${CAT_PID}"
+wait "${CAT_PID}" || :
+CAT_PID=""
+wait "${AWK_PID}"
+
+cat "${SUMMARY}"
+exit "${RET}"
@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * gen-tree [-f fanout] [-d depth] [-n files] [-l min[:max]] [-j threads]
+ *          [-s seed] <root>
+ *
+ * Generate a synthetic directory tree for benchmark fixtures, and print the
+ * path of each created directory and file on stdout.  Each directory has
+ * fanout subdirectories (until depth) and files regular files, with name
+ * lengths uniformly distributed between min and max.  The tree only depends on
+ * the parameters and the seed, not on the number of threads (but the order of
+ * the listed paths does).
+ *
+ * Entries are created relative to their parent directory's file descriptor
+ * (mkdirat and openat), to avoid path walks.  With several threads, the
+ * subtrees are distributed among them.
+ *
+ * ./gen-tree -f 10 -d 5 -n 10 -j 8 /mnt/tree > /mnt/tree.list
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NAME_MAX_LEN 255
+
+struct params {
+	unsigned int fanout;
+	unsigned int depth;
+	unsigned int files;
+	unsigned int name_min;
+	unsigned int name_max;
+};
+
+/* Directory whose content is created by a thread. */
+struct job {
+	char *path;
+	uint64_t state;
+	unsigned int level;
+	char *list;
+	size_t list_len;
+	unsigned long long dirs;
+	unsigned long long regs;
+	int err;
+};
+
+struct pool {
+	const struct params *params;
+	struct job *jobs;
+	size_t nb_jobs;
+	size_t next;
+	pthread_mutex_t lock;
+};
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/* Derives the state of a child from its parent's state and its index. */
+static uint64_t child_state(const uint64_t parent, const unsigned int idx,
+			    const bool dir)
+{
+	return splitmix64(parent ^ splitmix64(idx * 2 + dir));
+}
+
+/*
+ * Builds a unique name ("d" or "f" followed by the index in the parent), padded
+ * with pseudo-random characters up to a length drawn from the distribution.
+ */
+static void make_name(char *const name, const struct params *const params,
+		      uint64_t state, const unsigned int idx, const bool dir)
+{
+	const unsigned int range = params->name_max - params->name_min + 1;
+	unsigned int len, i;
+	int n;
+
+	n = snprintf(name, NAME_MAX_LEN + 1, "%c%u", dir ? 'd' : 'f', idx);
+	state = splitmix64(state);
+	len = params->name_min + state % range;
+	for (i = n; i < len; i++) {
+		state = splitmix64(state);
+		name[i] = 'a' + state % 26;
+	}
+	name[i] = '\0';
+}
+
+/* Creates the content of a directory, recursively. */
+static int fill_dir(const struct params *const params, const int dirfd,
+		    char *const path, const size_t path_len,
+		    const uint64_t state, const unsigned int level,
+		    FILE *const list, unsigned long long *const dirs,
+		    unsigned long long *const regs)
+{
+	char name[NAME_MAX_LEN + 1];
+	unsigned int i;
+	int fd, err;
+
+	for (i = 0; i < params->files; i++) {
+		make_name(name, params, child_state(state, i, false), i, false);
+		fd = openat(dirfd, name,
+			    O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "Failed to create %s/%s: %s\n", path,
+				name, strerror(errno));
+			return -1;
+		}
+		close(fd);
+		fprintf(list, "%s/%s\n", path, name);
+		(*regs)++;
+	}
+
+	if (level >= params->depth)
+		return 0;
+
+	for (i = 0; i < params->fanout; i++) {
+		const uint64_t sub_state = child_state(state, i, true);
+		size_t sub_len;
+
+		make_name(name, params, sub_state, i, true);
+		if (mkdirat(dirfd, name, 0755)) {
+			fprintf(stderr, "Failed to create %s/%s: %s\n", path,
+				name, strerror(errno));
+			return -1;
+		}
+		sub_len = path_len + 1 + strlen(name);
+		if (sub_len >= PATH_MAX) {
+			fprintf(stderr, "Path too long: %s/%s\n", path, name);
+			return -1;
+		}
+		path[path_len] = '/';
+		strcpy(path + path_len + 1, name);
+		fprintf(list, "%s\n", path);
+		(*dirs)++;
+
+		fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0) {
+			fprintf(stderr, "Failed to open %s: %s\n", path,
+				strerror(errno));
+			return -1;
+		}
+		err = fill_dir(params, fd, path, sub_len, sub_state, level + 1,
+			       list, dirs, regs);
+		close(fd);
+		path[path_len] = '\0';
+		if (err)
+			return err;
+	}
+	return 0;
+}
+
+static int run_job(const struct params *const params, struct job *const job)
+{
+	char path[PATH_MAX];
+	FILE *list;
+	int fd, err;
+
+	list = open_memstream(&job->list, &job->list_len);
+	if (!list)
+		return -1;
+
+	strcpy(path, job->path);
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path,
+			strerror(errno));
+		fclose(list);
+		return -1;
+	}
+	err = fill_dir(params, fd, path, strlen(path), job->state, job->level,
+		       list, &job->dirs, &job->regs);
+	close(fd);
+	fclose(list);
+	return err;
+}
+
+static void *worker(void *const arg)
+{
+	struct pool *const pool = arg;
+
+	while (true) {
+		size_t i;
+
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+		if (i >= pool->nb_jobs)
+			break;
+		pool->jobs[i].err = run_job(pool->params, &pool->jobs[i]);
+	}
+	return NULL;
+}
+
+/*
+ * Creates the first levels of the tree, until there are enough directories to
+ * keep the threads busy, and returns these directories as jobs.
+ */
+static int split_tree(const struct params *const params, const char *const root,
+		      const uint64_t seed, const unsigned int threads,
+		      struct pool *const pool, unsigned long long *const dirs,
+		      unsigned long long *const regs)
+{
+	unsigned int level = 0;
+	size_t i;
+
+	pool->jobs = calloc(1, sizeof(*pool->jobs));
+	if (!pool->jobs)
+		return -1;
+	pool->jobs[0].path = strdup(root);
+	pool->jobs[0].state = seed;
+	pool->nb_jobs = 1;
+	if (!pool->jobs[0].path)
+		return -1;
+
+	while (threads > 1 && pool->nb_jobs < threads * 4 &&
+	       level < params->depth && params->fanout) {
+		const size_t nb_jobs = pool->nb_jobs * params->fanout;
+		struct job *const jobs = calloc(nb_jobs, sizeof(*jobs));
+		size_t n = 0;
+
+		if (!jobs)
+			return -1;
+
+		for (i = 0; i < pool->nb_jobs; i++) {
+			struct job *const parent = &pool->jobs[i];
+			const struct params files_only = {
+				.files = params->files,
+				.name_min = params->name_min,
+				.name_max = params->name_max,
+			};
+			char name[NAME_MAX_LEN + 1];
+			unsigned int j;
+
+			/* Creates the parent's files but not its subdirectories. */
+			if (run_job(&files_only, parent))
+				return -1;
+
+			for (j = 0; j < params->fanout; j++) {
+				struct job *const job = &jobs[n++];
+
+				job->state = child_state(parent->state, j, true);
+				job->level = level + 1;
+				make_name(name, params, job->state, j, true);
+				if (asprintf(&job->path, "%s/%s", parent->path,
+					     name) < 0)
+					return -1;
+				if (mkdir(job->path, 0755)) {
+					fprintf(stderr,
+						"Failed to create %s: %s\n",
+						job->path, strerror(errno));
+					return -1;
+				}
+				(*dirs)++;
+			}
+
+			fwrite(parent->list, 1, parent->list_len, stdout);
+			for (j = 0; j < params->fanout; j++)
+				printf("%s\n", jobs[n - params->fanout + j].path);
+			*regs += parent->regs;
+			free(parent->list);
+			free(parent->path);
+		}
+		free(pool->jobs);
+		pool->jobs = jobs;
+		pool->nb_jobs = nb_jobs;
+		level++;
+	}
+	return 0;
+}
+
+static int parse_uint(const char *const str, unsigned int *const value)
+{
+	char *end;
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(str, &end, 10);
+	if (errno || end == str || *end || v > UINT_MAX)
+		return -1;
+	*value = v;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct params params = {
+		.fanout = 10,
+		.depth = 3,
+		.files = 10,
+		.name_min = 8,
+		.name_max = 8,
+	};
+	struct pool pool = {
+		.params = &params,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	};
+	unsigned int threads = 1, seed = 0, i;
+	unsigned long long dirs = 0, regs = 0;
+	struct timespec start, end;
+	pthread_t *tids;
+	const char *root;
+	char *sep;
+	int opt, ret = 0;
+
+	while ((opt = getopt(argc, argv, "f:d:n:l:j:s:")) != -1) {
+		switch (opt) {
+		case 'f':
+			if (parse_uint(optarg, &params.fanout))
+				goto usage;
+			break;
+		case 'd':
+			if (parse_uint(optarg, &params.depth))
+				goto usage;
+			break;
+		case 'n':
+			if (parse_uint(optarg, &params.files))
+				goto usage;
+			break;
+		case 'l':
+			sep = strchr(optarg, ':');
+			if (sep)
+				*sep = '\0';
+			if (parse_uint(optarg, &params.name_min) ||
+			    parse_uint(sep ? sep + 1 : optarg,
+				       &params.name_max))
+				goto usage;
+			break;
+		case 'j':
+			if (parse_uint(optarg, &threads) || !threads)
+				goto usage;
+			break;
+		case 's':
+			if (parse_uint(optarg, &seed))
+				goto usage;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || !params.name_min ||
+	    params.name_min > params.name_max ||
+	    params.name_max > NAME_MAX_LEN)
+		goto usage;
+
+	root = argv[optind];
+	if (mkdir(root, 0755) && errno != EEXIST) {
+		fprintf(stderr, "Failed to create %s: %s\n", root,
+			strerror(errno));
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (split_tree(&params, root, splitmix64(seed), threads, &pool, &dirs,
+		       &regs)) {
+		perror("Failed to create the tree");
+		return 1;
+	}
+
+	tids = calloc(threads, sizeof(*tids));
+	if (!tids) {
+		perror("Failed to allocate threads");
+		return 1;
+	}
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tids[i], NULL, worker, &pool)) {
+			fprintf(stderr, "Failed to create thread\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < threads; i++)
+		pthread_join(tids[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < pool.nb_jobs; i++) {
+		struct job *const job = &pool.jobs[i];
+
+		if (job->err)
+			ret = 1;
+		if (job->list)
+			fwrite(job->list, 1, job->list_len, stdout);
+		dirs += job->dirs;
+		regs += job->regs;
+	}
+
+	fprintf(stderr, "[*] Created %llu directories and %llu files in %.3f s\n",
+		dirs, regs,
+		(end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9);
+	return ret;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-f fanout] [-d depth] [-n files] [-l min[:max]] [-j threads] [-s seed] <root>\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,256 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Landlock helpers for the benchmarks, following samples/landlock/sandboxer.c
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#ifndef LANDLOCK_HELPERS_H
+#define LANDLOCK_HELPERS_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/landlock.h>
+#include <linux/prctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Access rights may be missing from the installed headers. */
+#ifndef LANDLOCK_ACCESS_FS_REFER
+#define LANDLOCK_ACCESS_FS_REFER (1ULL << 13)
+#endif
+
+#ifndef LANDLOCK_ACCESS_FS_TRUNCATE
+#define LANDLOCK_ACCESS_FS_TRUNCATE (1ULL << 14)
+#endif
+
+#ifndef LANDLOCK_ACCESS_FS_IOCTL_DEV
+#define LANDLOCK_ACCESS_FS_IOCTL_DEV (1ULL << 15)
+#endif
+
+#ifndef landlock_create_ruleset
+static inline int
+landlock_create_ruleset(const struct landlock_ruleset_attr *const attr,
+			const size_t size, const __u32 flags)
+{
+	return syscall(__NR_landlock_create_ruleset, attr, size, flags);
+}
+#endif
+
+#ifndef landlock_add_rule
+static inline int landlock_add_rule(const int ruleset_fd,
+				    const enum landlock_rule_type rule_type,
+				    const void *const rule_attr,
+				    const __u32 flags)
+{
+	return syscall(__NR_landlock_add_rule, ruleset_fd, rule_type, rule_attr,
+		       flags);
+}
+#endif
+
+#ifndef landlock_restrict_self
+static inline int landlock_restrict_self(const int ruleset_fd,
+					 const __u32 flags)
+{
+	return syscall(__NR_landlock_restrict_self, ruleset_fd, flags);
+}
+#endif
+
+/* clang-format off */
+
+#define LL_ACCESS_FILE ( \
+	LANDLOCK_ACCESS_FS_EXECUTE | \
+	LANDLOCK_ACCESS_FS_WRITE_FILE | \
+	LANDLOCK_ACCESS_FS_READ_FILE | \
+	LANDLOCK_ACCESS_FS_TRUNCATE | \
+	LANDLOCK_ACCESS_FS_IOCTL_DEV)
+
+#define LL_ACCESS_FS_ROUGHLY_READ ( \
+	LANDLOCK_ACCESS_FS_EXECUTE | \
+	LANDLOCK_ACCESS_FS_READ_FILE | \
+	LANDLOCK_ACCESS_FS_READ_DIR)
+
+#define LL_ACCESS_FS_ROUGHLY_WRITE ( \
+	LANDLOCK_ACCESS_FS_WRITE_FILE | \
+	LANDLOCK_ACCESS_FS_REMOVE_DIR | \
+	LANDLOCK_ACCESS_FS_REMOVE_FILE | \
+	LANDLOCK_ACCESS_FS_MAKE_CHAR | \
+	LANDLOCK_ACCESS_FS_MAKE_DIR | \
+	LANDLOCK_ACCESS_FS_MAKE_REG | \
+	LANDLOCK_ACCESS_FS_MAKE_SOCK | \
+	LANDLOCK_ACCESS_FS_MAKE_FIFO | \
+	LANDLOCK_ACCESS_FS_MAKE_BLOCK | \
+	LANDLOCK_ACCESS_FS_MAKE_SYM | \
+	LANDLOCK_ACCESS_FS_REFER | \
+	LANDLOCK_ACCESS_FS_TRUNCATE | \
+	LANDLOCK_ACCESS_FS_IOCTL_DEV)
+
+/* clang-format on */
+
+/* Returns the Landlock ABI version, or -1 if Landlock is not available. */
+static inline int ll_get_abi(void)
+{
+	return landlock_create_ruleset(NULL, 0,
+				       LANDLOCK_CREATE_RULESET_VERSION);
+}
+
+/* Returns all the filesystem access rights supported by an ABI version. */
+static inline __u64 ll_fs_access_supported(const int abi)
+{
+	__u64 access = (LANDLOCK_ACCESS_FS_MAKE_SYM << 1) - 1;
+
+	if (abi >= 2)
+		access |= LANDLOCK_ACCESS_FS_REFER;
+	if (abi >= 3)
+		access |= LANDLOCK_ACCESS_FS_TRUNCATE;
+	if (abi >= 5)
+		access |= LANDLOCK_ACCESS_FS_IOCTL_DEV;
+	return access;
+}
+
+/*
+ * Creates a ruleset handling the given filesystem access rights, restricted
+ * to the ones supported by the running kernel.
+ */
+static inline int ll_create_ruleset(const __u64 handled_access_fs)
+{
+	const int abi = ll_get_abi();
+	struct landlock_ruleset_attr attr = {};
+
+	if (abi < 0)
+		return -1;
+
+	attr.handled_access_fs = handled_access_fs &
+				 ll_fs_access_supported(abi);
+	return landlock_create_ruleset(&attr, sizeof(attr), 0);
+}
+
+/*
+ * Adds a path-beneath rule, only with file access rights for non-directories,
+ * and only with the access rights supported by the running kernel.
+ */
+static inline int ll_add_path(const int ruleset_fd, const char *const path,
+			      __u64 allowed_access)
+{
+	struct landlock_path_beneath_attr attr = {};
+	struct stat statbuf;
+	int err;
+
+	attr.parent_fd = open(path, O_PATH | O_CLOEXEC);
+	if (attr.parent_fd < 0)
+		return -1;
+
+	if (fstat(attr.parent_fd, &statbuf)) {
+		err = errno;
+		close(attr.parent_fd);
+		errno = err;
+		return -1;
+	}
+	if (!S_ISDIR(statbuf.st_mode))
+		allowed_access &= LL_ACCESS_FILE;
+
+	/* Must be a subset of the access rights handled by the ruleset. */
+	attr.allowed_access = allowed_access &
+			      ll_fs_access_supported(ll_get_abi());
+
+	err = landlock_add_rule(ruleset_fd, LANDLOCK_RULE_PATH_BENEATH, &attr,
+				0);
+	if (err)
+		err = errno;
+	close(attr.parent_fd);
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+/* Adds rules for a colon-separated list of paths (e.g. LL_FS_RO). */
+static inline int ll_add_paths(const int ruleset_fd, const char *const paths,
+			       const __u64 allowed_access)
+{
+	char *list, *path, *saveptr = NULL;
+	int err = 0;
+
+	if (!paths || !*paths)
+		return 0;
+
+	list = strdup(paths);
+	if (!list)
+		return -1;
+
+	for (path = strtok_r(list, ":", &saveptr); path;
+	     path = strtok_r(NULL, ":", &saveptr)) {
+		if (ll_add_path(ruleset_fd, path, allowed_access)) {
+			fprintf(stderr, "Failed to add rule for \"%s\": %s\n",
+				path, strerror(errno));
+			err = -1;
+			break;
+		}
+	}
+	free(list);
+	return err;
+}
+
+/* Enforces a ruleset on the calling thread. */
+static inline int ll_restrict(const int ruleset_fd)
+{
+	if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0))
+		return -1;
+	return landlock_restrict_self(ruleset_fd, 0);
+}
+
+/*
+ * Creates a ruleset from sandboxer-like environment variables (LL_FS_RO and
+ * LL_FS_RW), handling all the supported filesystem access rights.
+ */
+static inline int ll_create_ruleset_from_env(void)
+{
+	const int ruleset_fd =
+		ll_create_ruleset(LL_ACCESS_FS_ROUGHLY_READ |
+				  LL_ACCESS_FS_ROUGHLY_WRITE);
+
+	if (ruleset_fd < 0)
+		return -1;
+
+	if (ll_add_paths(ruleset_fd, getenv("LL_FS_RO"),
+			 LL_ACCESS_FS_ROUGHLY_READ) ||
+	    ll_add_paths(ruleset_fd, getenv("LL_FS_RW"),
+			 LL_ACCESS_FS_ROUGHLY_READ |
+				 LL_ACCESS_FS_ROUGHLY_WRITE)) {
+		close(ruleset_fd);
+		return -1;
+	}
+	return ruleset_fd;
+}
+
+/* Sandboxes the calling thread according to LL_FS_RO and LL_FS_RW. */
+static inline int ll_sandbox_from_env(void)
+{
+	const int ruleset_fd = ll_create_ruleset_from_env();
+	int err;
+
+	if (ruleset_fd < 0)
+		return -1;
+
+	err = ll_restrict(ruleset_fd);
+	if (err)
+		err = errno;
+	close(ruleset_fd);
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+#endif /* LANDLOCK_HELPERS_H */
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Landlock hook latency histograms, cf. landlock-lat.c
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#include "vmlinux.h"
+
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+
+#include "landlock-lat.h"
+
+char LICENSE[] SEC("license") = "GPL";
+
+/* Entry timestamps, per thread. */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 16384);
+	__type(key, __u32);
+	__type(value, __u64);
+} start SEC(".maps");
+
+/* Per-CPU to not share cache lines between CPUs, summed by user space. */
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, LANDLOCK_LAT_MAX);
+	__type(key, __u32);
+	__type(value, struct landlock_lat_hist);
+} hists SEC(".maps");
+
+static __always_inline __u32 log2_u64(__u64 v)
+{
+	__u32 r = 0, shift;
+
+	shift = (v > 0xFFFFFFFF) << 5;
+	v >>= shift;
+	r |= shift;
+	shift = (v > 0xFFFF) << 4;
+	v >>= shift;
+	r |= shift;
+	shift = (v > 0xFF) << 3;
+	v >>= shift;
+	r |= shift;
+	shift = (v > 0xF) << 2;
+	v >>= shift;
+	r |= shift;
+	shift = (v > 0x3) << 1;
+	v >>= shift;
+	r |= shift;
+	r |= (v >> 1);
+	return r;
+}
+
+static __always_inline int hook_entry(void)
+{
+	const __u32 tid = (__u32)bpf_get_current_pid_tgid();
+	const __u64 ts = bpf_ktime_get_ns();
+
+	bpf_map_update_elem(&start, &tid, &ts, BPF_ANY);
+	return 0;
+}
+
+static __always_inline int hook_exit(__u32 id)
+{
+	const __u32 tid = (__u32)bpf_get_current_pid_tgid();
+	struct landlock_lat_hist *hist;
+	__u64 *ts, delta;
+	__u32 slot;
+
+	ts = bpf_map_lookup_elem(&start, &tid);
+	if (!ts)
+		return 0;
+
+	delta = bpf_ktime_get_ns() - *ts;
+	bpf_map_delete_elem(&start, &tid);
+
+	hist = bpf_map_lookup_elem(&hists, &id);
+	if (!hist)
+		return 0;
+
+	slot = log2_u64(delta);
+	if (slot >= LANDLOCK_LAT_SLOTS)
+		slot = LANDLOCK_LAT_SLOTS - 1;
+
+	hist->count++;
+	hist->total_ns += delta;
+	hist->slots[slot]++;
+	return 0;
+}
+
+#define LANDLOCK_LAT_PROGS(name)                        \
+	SEC("fentry/" #name)                            \
+	int BPF_PROG(name##_entry)                      \
+	{                                               \
+		return hook_entry();                    \
+	}                                               \
+	SEC("fexit/" #name)                             \
+	int BPF_PROG(name##_exit)                       \
+	{                                               \
+		return hook_exit(LANDLOCK_LAT_ID_##name); \
+	}
+
+LANDLOCK_LAT_HOOKS(LANDLOCK_LAT_PROGS)
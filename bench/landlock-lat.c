@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * landlock-lat [interval-seconds [count]]
+ *
+ * Print the latency histograms and call counts of Landlock's LSM hooks, every
+ * interval (default: 5 seconds), until interrupted or count intervals.
+ *
+ * Hooks are measured with fentry/fexit BPF programs aggregating in per-CPU
+ * maps, without per-event output, to measure Landlock's cost on production
+ * workloads.  Requires a kernel with BTF (CONFIG_DEBUG_INFO_BTF).
+ *
+ * sudo ./landlock-lat 10
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#include <bpf/btf.h>
+#include <bpf/libbpf.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-lat.h"
+#include "landlock-lat.skel.h"
+
+#define LANDLOCK_LAT_NAME(name) #name,
+
+static const char *const hook_names[] = { LANDLOCK_LAT_HOOKS(
+	LANDLOCK_LAT_NAME) };
+
+static volatile sig_atomic_t exiting;
+
+static void sig_handler(int sig)
+{
+	exiting = 1;
+}
+
+/* Only loads programs attached to functions of the running kernel. */
+static int disable_missing_hooks(struct bpf_object *obj)
+{
+	struct btf *vmlinux;
+	struct bpf_program *prog;
+
+	vmlinux = btf__load_vmlinux_btf();
+	if (!vmlinux)
+		return -errno;
+
+	bpf_object__for_each_program(prog, obj) {
+		const char *target = strchr(bpf_program__section_name(prog), '/');
+
+		if (!target)
+			continue;
+
+		if (btf__find_by_name_kind(vmlinux, target + 1, BTF_KIND_FUNC) <
+		    0)
+			bpf_program__set_autoload(prog, false);
+	}
+	btf__free(vmlinux);
+	return 0;
+}
+
+static void print_stars(__u64 val, __u64 max, int width)
+{
+	int i, stars = max ? val * width / max : 0;
+
+	for (i = 0; i < width; i++)
+		putchar(i < stars ? '*' : ' ');
+}
+
+static void print_hist(const char *name, const struct landlock_lat_hist *hist)
+{
+	int i, first = -1, last = -1;
+	__u64 max = 0;
+
+	for (i = 0; i < LANDLOCK_LAT_SLOTS; i++) {
+		if (!hist->slots[i])
+			continue;
+		if (first < 0)
+			first = i;
+		last = i;
+		if (hist->slots[i] > max)
+			max = hist->slots[i];
+	}
+
+	printf("%s: %llu calls, avg %llu ns\n", name, hist->count,
+	       hist->total_ns / hist->count);
+	printf("%24s : %-10s distribution\n", "ns", "count");
+	for (i = first; i >= 0 && i <= last; i++) {
+		printf("%10llu -> %-10llu : %-10llu |", i ? 1ULL << i : 0,
+		       (1ULL << (i + 1)) - 1, hist->slots[i]);
+		print_stars(hist->slots[i], max, 40);
+		printf("|\n");
+	}
+	printf("\n");
+}
+
+static int print_hists(struct landlock_lat_bpf *skel, int ncpus)
+{
+	struct landlock_lat_hist *values, sum;
+	__u32 id;
+	int cpu, i, err = 0;
+	time_t now = time(NULL);
+	char date[32];
+
+	values = calloc(ncpus, sizeof(*values));
+	if (!values)
+		return -ENOMEM;
+
+	strftime(date, sizeof(date), "%F %T", localtime(&now));
+	printf("=== %s ===\n\n", date);
+
+	for (id = 0; id < LANDLOCK_LAT_MAX; id++) {
+		err = bpf_map__lookup_elem(skel->maps.hists, &id, sizeof(id),
+					   values, sizeof(*values) * ncpus, 0);
+		if (err)
+			break;
+
+		memset(&sum, 0, sizeof(sum));
+		for (cpu = 0; cpu < ncpus; cpu++) {
+			sum.count += values[cpu].count;
+			sum.total_ns += values[cpu].total_ns;
+			for (i = 0; i < LANDLOCK_LAT_SLOTS; i++)
+				sum.slots[i] += values[cpu].slots[i];
+		}
+		if (sum.count)
+			print_hist(hook_names[id], &sum);
+	}
+	fflush(stdout);
+	free(values);
+	return err;
+}
+
+int main(int argc, char *argv[])
+{
+	struct landlock_lat_bpf *skel;
+	int interval = 5, count = -1, ncpus, err;
+
+	if (argc > 3) {
+		fprintf(stderr, "usage: %s [interval-seconds [count]]\n",
+			argv[0]);
+		return 1;
+	}
+	if (argc > 1)
+		interval = atoi(argv[1]);
+	if (argc > 2)
+		count = atoi(argv[2]);
+	if (interval <= 0 || count == 0) {
+		fprintf(stderr, "Invalid interval or count\n");
+		return 1;
+	}
+
+	ncpus = libbpf_num_possible_cpus();
+	if (ncpus < 0) {
+		fprintf(stderr, "Failed to get the number of CPUs: %s\n",
+			strerror(-ncpus));
+		return 1;
+	}
+
+	skel = landlock_lat_bpf__open();
+	if (!skel) {
+		perror("Failed to open the BPF object");
+		return 1;
+	}
+
+	err = disable_missing_hooks(skel->obj);
+	if (err) {
+		fprintf(stderr, "Failed to load the kernel BTF: %s\n",
+			strerror(-err));
+		goto out;
+	}
+
+	err = landlock_lat_bpf__load(skel);
+	if (err) {
+		fprintf(stderr, "Failed to load the BPF object: %s\n",
+			strerror(-err));
+		goto out;
+	}
+
+	err = landlock_lat_bpf__attach(skel);
+	if (err) {
+		fprintf(stderr, "Failed to attach the BPF programs: %s\n",
+			strerror(-err));
+		goto out;
+	}
+
+	signal(SIGINT, sig_handler);
+	signal(SIGTERM, sig_handler);
+
+	printf("Tracing Landlock hooks... Hit Ctrl-C to end.\n\n");
+	while (!exiting && count != 0) {
+		sleep(interval);
+		err = print_hists(skel, ncpus);
+		if (err) {
+			fprintf(stderr, "Failed to read the histograms: %s\n",
+				strerror(-err));
+			break;
+		}
+		if (count > 0)
+			count--;
+	}
+
+out:
+	landlock_lat_bpf__destroy(skel);
+	return err ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Shared between landlock-lat.bpf.c and landlock-lat.c
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#ifndef LANDLOCK_LAT_H
+#define LANDLOCK_LAT_H
+
+/* Log2 slots, in nanoseconds: up to 2^31 ns (about 2 seconds). */
+#define LANDLOCK_LAT_SLOTS 32
+
+/* Landlock's LSM hooks worth measuring, missing ones are ignored. */
+#define LANDLOCK_LAT_HOOKS(X)   \
+	X(hook_file_open)       \
+	X(hook_file_truncate)   \
+	X(hook_file_ioctl)      \
+	X(hook_path_truncate)   \
+	X(hook_path_mknod)      \
+	X(hook_path_mkdir)      \
+	X(hook_path_symlink)    \
+	X(hook_path_unlink)     \
+	X(hook_path_rmdir)      \
+	X(hook_path_link)       \
+	X(hook_path_rename)     \
+	X(hook_sb_mount)        \
+	X(hook_move_mount)      \
+	X(hook_socket_bind)     \
+	X(hook_socket_connect)  \
+	X(hook_ptrace_access_check)
+
+#define LANDLOCK_LAT_ID(name) LANDLOCK_LAT_ID_##name,
+
+enum landlock_lat_id {
+	LANDLOCK_LAT_HOOKS(LANDLOCK_LAT_ID)
+	LANDLOCK_LAT_MAX
+};
+
+struct landlock_lat_hist {
+	__u64 count;
+	__u64 total_ns;
+	__u64 slots[LANDLOCK_LAT_SLOTS];
+};
+
+#endif /* LANDLOCK_LAT_H */
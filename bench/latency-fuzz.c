@@ -0,0 +1,720 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * latency-fuzz [-i iterations] [-p population] [-n ntimes] [-s seed]
+ *              [-t top] [-o dir] <dir>
+ * latency-fuzz [-n ntimes] -c <config> <dir>
+ *
+ * Search for the policies and filesystem layouts maximizing the Landlock
+ * overhead of open(2), i.e. the difference between a sandboxed and an
+ * unsandboxed open(2) of the same file.
+ *
+ * A configuration is a set of genes:
+ * - depth: depth of the opened file in a directory chain;
+ * - walk: number of path components walked up from the file to the rule
+ *   granting access;
+ * - rules: number of other rules on the chain, which do not grant access;
+ * - wide: number of rules on unrelated directories (ruleset size);
+ * - layers: number of stacked domains;
+ * - staggered: whether each layer grants access at a different level, up to
+ *   the top of the chain;
+ * - mounts: number of bind mounts crossed (requires CAP_SYS_ADMIN);
+ * - symlinks: number of symbolic links followed to reach the file;
+ * - write: whether the file is opened for writing.
+ *
+ * The search is a steady-state evolutionary algorithm guided by the measured
+ * overhead: a configuration mutated from a good one replaces the worst one of
+ * the population if it is slower.  The top configurations are measured again
+ * and printed as "[fuzz]" lines.  With -o, a reproducer script is written for
+ * each of them, to be run under UML next to a copy of latency-fuzz (not in /tmp
+ * nor /run, which are not shared with the guest):
+ *
+ * .../uml-run.sh .../linux -- .../repro-1.sh
+ *
+ * With -c, only the given configuration is measured (e.g.
+ * "depth=8,walk=4,layers=2").
+ *
+ * IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./latency-fuzz -i 500 /tmp
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+#define MAX_DEPTH 64
+#define MAX_WIDE 1024
+#define BATCHES 5
+#define REMEASURES 3
+
+enum gene {
+	GENE_DEPTH,
+	GENE_WALK,
+	GENE_RULES,
+	GENE_WIDE,
+	GENE_LAYERS,
+	GENE_STAGGERED,
+	GENE_MOUNTS,
+	GENE_SYMLINKS,
+	GENE_WRITE,
+	NB_GENES,
+};
+
+static const struct {
+	const char *name;
+	int min;
+	int max;
+} genes[NB_GENES] = {
+	[GENE_DEPTH] = { "depth", 1, MAX_DEPTH },
+	[GENE_WALK] = { "walk", 1, MAX_DEPTH + 1 },
+	[GENE_RULES] = { "rules", 0, 128 },
+	[GENE_WIDE] = { "wide", 0, MAX_WIDE },
+	/* Cf. LANDLOCK_MAX_NUM_LAYERS */
+	[GENE_LAYERS] = { "layers", 1, 16 },
+	[GENE_STAGGERED] = { "staggered", 0, 1 },
+	[GENE_MOUNTS] = { "mounts", 0, 32 },
+	/* Below MAXSYMLINKS (40). */
+	[GENE_SYMLINKS] = { "symlinks", 0, 32 },
+	[GENE_WRITE] = { "write", 0, 1 },
+};
+
+struct config {
+	int v[NB_GENES];
+	double base;
+	double sandbox;
+};
+
+/* Directory chain: dirs[0] is the top, and files[i] is in dirs[i]. */
+static char dirs[MAX_DEPTH + 1][PATH_MAX];
+static char files[MAX_DEPTH + 1][PATH_MAX];
+static char wide_dir[PATH_MAX];
+static char links_dir[PATH_MAX];
+static bool can_mount = true;
+static uint64_t rng_state;
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static unsigned int rnd(const unsigned int n)
+{
+	rng_state = splitmix64(rng_state);
+	return rng_state % n;
+}
+
+static int clamp(const int v, const int min, const int max)
+{
+	return v < min ? min : v > max ? max : v;
+}
+
+/* Enforces the constraints between genes. */
+static void fix_config(struct config *const config)
+{
+	int *const v = config->v;
+	unsigned int g;
+
+	for (g = 0; g < NB_GENES; g++)
+		v[g] = clamp(v[g], genes[g].min, genes[g].max);
+	v[GENE_WALK] = clamp(v[GENE_WALK], 1, v[GENE_DEPTH] + 1);
+	/* Mount points are strictly below the top of the chain. */
+	v[GENE_MOUNTS] = clamp(v[GENE_MOUNTS], 0,
+			       can_mount ? v[GENE_DEPTH] : 0);
+}
+
+static void random_config(struct config *const config)
+{
+	unsigned int g;
+
+	for (g = 0; g < NB_GENES; g++)
+		config->v[g] =
+			genes[g].min + rnd(genes[g].max - genes[g].min + 1);
+	fix_config(config);
+}
+
+/* Changes one to three genes, by a small step or to a random value. */
+static void mutate(struct config *const config)
+{
+	const unsigned int nb = 1 + rnd(3);
+	unsigned int i;
+
+	for (i = 0; i < nb; i++) {
+		const unsigned int g = rnd(NB_GENES);
+		const int range = genes[g].max - genes[g].min;
+		const int step = 1 + rnd(range / 4 + 1);
+
+		if (!rnd(4))
+			config->v[g] = genes[g].min + rnd(range + 1);
+		else
+			config->v[g] += rnd(2) ? step : -step;
+	}
+	fix_config(config);
+}
+
+static void format_config(const struct config *const config, char *const buf,
+			  const size_t size)
+{
+	size_t len = 0;
+	unsigned int g;
+
+	buf[0] = '\0';
+	for (g = 0; g < NB_GENES && len < size; g++)
+		len += snprintf(buf + len, size - len, "%s%s=%d", g ? "," : "",
+				genes[g].name, config->v[g]);
+}
+
+static int parse_config(char *const str, struct config *const config)
+{
+	char *token, *saveptr = NULL, *list, *value;
+	unsigned int g;
+
+	/* Unspecified genes get the simplest value. */
+	for (g = 0; g < NB_GENES; g++)
+		config->v[g] = genes[g].min;
+
+	for (list = str; (token = strtok_r(list, ",", &saveptr)); list = NULL) {
+		value = strchr(token, '=');
+		if (!value)
+			return -1;
+		*value++ = '\0';
+		for (g = 0; g < NB_GENES; g++) {
+			if (!strcmp(token, genes[g].name))
+				break;
+		}
+		if (g == NB_GENES)
+			return -1;
+		config->v[g] = atoi(value);
+	}
+	fix_config(config);
+	return 0;
+}
+
+/* Formats a path, and fails with ENAMETOOLONG if it is truncated. */
+static int format_path(char *const buf, const size_t size,
+		       const char *const fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+	if (len < 0 || len >= size) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	return 0;
+}
+
+static int create_layout(const char *const dir)
+{
+	char path[PATH_MAX];
+	int i, fd;
+
+	if (format_path(path, sizeof(path), "%s/latency-fuzz", dir))
+		return -1;
+	if (mkdir(path, 0755) && errno != EEXIST)
+		return -1;
+
+	if (format_path(wide_dir, sizeof(wide_dir), "%s/wide", path) ||
+	    format_path(links_dir, sizeof(links_dir), "%s/links", path) ||
+	    format_path(dirs[0], sizeof(dirs[0]), "%s/chain", path))
+		return -1;
+	for (i = 1; i <= MAX_DEPTH; i++) {
+		if (format_path(dirs[i], sizeof(dirs[i]), "%s/%d", dirs[i - 1],
+				i))
+			return -1;
+	}
+
+	if ((mkdir(wide_dir, 0755) && errno != EEXIST) ||
+	    (mkdir(links_dir, 0755) && errno != EEXIST))
+		return -1;
+
+	for (i = 0; i < MAX_WIDE; i++) {
+		if (format_path(path, sizeof(path), "%s/%d", wide_dir, i))
+			return -1;
+		if (mkdir(path, 0755) && errno != EEXIST)
+			return -1;
+	}
+
+	for (i = 0; i <= MAX_DEPTH; i++) {
+		if (mkdir(dirs[i], 0755) && errno != EEXIST)
+			return -1;
+		if (format_path(files[i], sizeof(files[i]), "%s/file", dirs[i]))
+			return -1;
+		fd = open(files[i], O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (fd < 0)
+			return -1;
+		close(fd);
+	}
+	return 0;
+}
+
+/* Returns the path to open, through a chain of symbolic links if any. */
+static int create_links(const struct config *const config, char *const path,
+			const size_t size)
+{
+	const int nb = config->v[GENE_SYMLINKS];
+	char link[PATH_MAX], target[PATH_MAX];
+	int i;
+
+	for (i = nb - 1; i >= 0; i--) {
+		if (format_path(link, sizeof(link), "%s/%d", links_dir, i))
+			return -1;
+		if (i == nb - 1 ?
+			    format_path(target, sizeof(target), "%s",
+					files[config->v[GENE_DEPTH]]) :
+			    format_path(target, sizeof(target), "%d", i + 1))
+			return -1;
+		if (unlink(link) && errno != ENOENT)
+			return -1;
+		if (symlink(target, link))
+			return -1;
+	}
+
+	if (nb)
+		return format_path(path, size, "%s/0", links_dir);
+	return format_path(path, size, "%s", files[config->v[GENE_DEPTH]]);
+}
+
+/* Spreads n items over the levels [first, last]. */
+static int spread(const int i, const int n, const int first, const int last)
+{
+	return first + (long)i * (last - first + 1) / n;
+}
+
+static int add_mounts(const struct config *const config)
+{
+	int i;
+
+	if (!config->v[GENE_MOUNTS])
+		return 0;
+
+	if (unshare(CLONE_NEWNS) ||
+	    mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL))
+		return -1;
+
+	for (i = 0; i < config->v[GENE_MOUNTS]; i++) {
+		const char *const path = dirs[spread(i, config->v[GENE_MOUNTS],
+						     1, config->v[GENE_DEPTH])];
+
+		if (mount(path, path, NULL, MS_BIND, NULL))
+			return -1;
+	}
+	return 0;
+}
+
+static int sandbox(const struct config *const config)
+{
+	const int depth = config->v[GENE_DEPTH];
+	const int layers = config->v[GENE_LAYERS];
+	const int grant = depth + 1 - config->v[GENE_WALK];
+	const __u64 granted = LL_ACCESS_FS_ROUGHLY_READ |
+			      LL_ACCESS_FS_ROUGHLY_WRITE;
+	int layer, i;
+
+	for (layer = 0; layer < layers; layer++) {
+		const int ruleset_fd = ll_create_ruleset(granted);
+		char path[PATH_MAX];
+		int err;
+
+		if (ruleset_fd < 0)
+			return -1;
+
+		/* Staggered layers grant access from the top to the walk. */
+		err = ll_add_path(ruleset_fd,
+				  dirs[config->v[GENE_STAGGERED] ?
+					       spread(layer, layers, 0, grant) :
+					       grant],
+				  granted);
+
+		for (i = 0; !err && i < config->v[GENE_RULES]; i++)
+			err = ll_add_path(ruleset_fd,
+					  dirs[spread(i, config->v[GENE_RULES],
+						      0, depth)],
+					  LANDLOCK_ACCESS_FS_EXECUTE);
+
+		for (i = 0; !err && i < config->v[GENE_WIDE]; i++) {
+			err = format_path(path, sizeof(path), "%s/%d", wide_dir,
+					  i);
+			if (!err)
+				err = ll_add_path(ruleset_fd, path,
+						  LANDLOCK_ACCESS_FS_EXECUTE);
+		}
+
+		if (!err)
+			err = ll_restrict(ruleset_fd);
+		close(ruleset_fd);
+		if (err)
+			return -1;
+	}
+	return 0;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_double(const void *const a, const void *const b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Returns the median of the batch averages, in nanoseconds. */
+static double measure(const char *const path, const int flags,
+		      const int ntimes)
+{
+	double batches[BATCHES];
+	int b, i, fd;
+
+	for (b = 0; b < BATCHES; b++) {
+		const unsigned long long start = now_ns();
+
+		for (i = 0; i < ntimes / BATCHES; i++) {
+			fd = open(path, flags | O_CLOEXEC);
+			if (fd < 0)
+				return -1;
+			close(fd);
+		}
+		batches[b] = (double)(now_ns() - start) / (ntimes / BATCHES);
+	}
+	qsort(batches, BATCHES, sizeof(*batches), cmp_double);
+	return batches[BATCHES / 2];
+}
+
+static int run(const struct config *const config, const bool sandboxed,
+	       const int ntimes, double *const ns)
+{
+	const int flags = config->v[GENE_WRITE] ? O_WRONLY : O_RDONLY;
+	char path[PATH_MAX];
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (create_links(config, path, sizeof(path)))
+		return -1;
+
+	if (pipe2(pipefd, O_CLOEXEC))
+		return -1;
+
+	child = fork();
+	if (child < 0)
+		return -1;
+	if (!child) {
+		close(pipefd[0]);
+		if (add_mounts(config)) {
+			perror("Failed to create mount points");
+			_exit(1);
+		}
+		if (sandboxed && sandbox(config)) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		*ns = measure(path, flags, ntimes);
+		if (*ns < 0) {
+			perror("Failed to open");
+			_exit(1);
+		}
+		if (write(pipefd[1], ns, sizeof(*ns)) != sizeof(*ns))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], ns, sizeof(*ns)) == sizeof(*ns);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+static int evaluate(struct config *const config, const int ntimes)
+{
+	if (run(config, false, ntimes, &config->base) ||
+	    run(config, true, ntimes, &config->sandbox))
+		return -1;
+	return 0;
+}
+
+static double overhead(const struct config *const config)
+{
+	return config->sandbox - config->base;
+}
+
+/* Measures a configuration several times, and keeps the median overhead. */
+static int remeasure(struct config *const config, const int ntimes)
+{
+	struct config runs[REMEASURES];
+	double overheads[REMEASURES];
+	int i;
+
+	for (i = 0; i < REMEASURES; i++) {
+		runs[i] = *config;
+		if (evaluate(&runs[i], ntimes))
+			return -1;
+		overheads[i] = overhead(&runs[i]);
+	}
+	qsort(overheads, REMEASURES, sizeof(*overheads), cmp_double);
+	for (i = 0; i < REMEASURES; i++) {
+		if (overhead(&runs[i]) == overheads[REMEASURES / 2]) {
+			*config = runs[i];
+			break;
+		}
+	}
+	return 0;
+}
+
+static void print_config(const char *const prefix,
+			 const struct config *const config)
+{
+	char buf[256];
+
+	format_config(config, buf, sizeof(buf));
+	printf("[fuzz] %s%s base=%.1f sandbox=%.1f overhead=%.1f\n", prefix,
+	       buf, config->base, config->sandbox, overhead(config));
+	fflush(stdout);
+}
+
+static int write_reproducer(const char *const dir, const int rank,
+			    const struct config *const config,
+			    const int ntimes)
+{
+	char path[PATH_MAX], buf[256];
+	FILE *out;
+
+	if (snprintf(path, sizeof(path), "%s/repro-%d.sh", dir, rank) >=
+	    sizeof(path))
+		return -1;
+	out = fopen(path, "w");
+	if (!out)
+		return -1;
+
+	format_config(config, buf, sizeof(buf));
+	fprintf(out,
+		"#!/usr/bin/env bash\n"
+		"#\n"
+		"# latency-fuzz reproducer, rank %d: %.1f ns of Landlock overhead for open(2)\n"
+		"# (base=%.1f sandbox=%.1f)\n"
+		"#\n"
+		"# Requires a copy of latency-fuzz in the same directory, e.g. under UML:\n"
+		"# .../uml-run.sh .../linux -- %s\n"
+		"\n"
+		"set -e -u -o pipefail\n"
+		"\n"
+		"DIRNAME=\"$(dirname -- \"$(readlink -f -- \"${BASH_SOURCE[0]}\")\")\"\n"
+		"\n"
+		"unshare --mount -- \"${DIRNAME}/latency-fuzz\" -n %d -c \"%s\" \"${TMPDIR:-/tmp}\"\n",
+		rank, overhead(config), config->base, config->sandbox, path,
+		ntimes, buf);
+	if (fclose(out) || chmod(path, 0755))
+		return -1;
+	return 0;
+}
+
+static int cmp_overhead(const void *const a, const void *const b)
+{
+	const double x = overhead(a), y = overhead(b);
+
+	return (x < y) - (x > y);
+}
+
+static int search(const unsigned int iterations, const unsigned int size,
+		  const unsigned int top, const int ntimes,
+		  const char *const out_dir)
+{
+	struct config *const population = calloc(size, sizeof(*population));
+	unsigned int i, worst, best = 0;
+
+	if (!population)
+		return -1;
+
+	for (i = 0; i < size; i++) {
+		random_config(&population[i]);
+		if (evaluate(&population[i], ntimes))
+			goto err;
+		if (overhead(&population[i]) > overhead(&population[best]))
+			best = i;
+	}
+	print_config("best ", &population[best]);
+
+	for (i = 0; i < iterations; i++) {
+		const unsigned int a = rnd(size), b = rnd(size);
+		struct config child;
+		unsigned int j;
+
+		/* Tournament selection of the parent. */
+		child = population[overhead(&population[a]) >
+						   overhead(&population[b]) ?
+					   a :
+					   b];
+		mutate(&child);
+		if (evaluate(&child, ntimes))
+			goto err;
+
+		worst = 0;
+		for (j = 1; j < size; j++) {
+			if (overhead(&population[j]) <
+			    overhead(&population[worst]))
+				worst = j;
+		}
+		if (overhead(&child) <= overhead(&population[worst]))
+			continue;
+
+		population[worst] = child;
+		if (overhead(&child) > overhead(&population[best])) {
+			best = worst;
+			fprintf(stderr, "[*] Iteration %u/%u\n", i + 1,
+				iterations);
+			print_config("best ", &child);
+		}
+	}
+
+	/* Lucky measurements should not make it to the top. */
+	for (i = 0; i < size; i++) {
+		if (remeasure(&population[i], ntimes))
+			goto err;
+	}
+	qsort(population, size, sizeof(*population), cmp_overhead);
+
+	for (i = 0; i < top && i < size; i++) {
+		char prefix[32];
+
+		snprintf(prefix, sizeof(prefix), "rank=%u ", i + 1);
+		print_config(prefix, &population[i]);
+		if (out_dir &&
+		    write_reproducer(out_dir, i + 1, &population[i], ntimes)) {
+			perror("Failed to write the reproducer");
+			goto err;
+		}
+	}
+	free(population);
+	return 0;
+
+err:
+	free(population);
+	return -1;
+}
+
+/* Checks if mount points can be created, in a child process. */
+static bool check_mount(void)
+{
+	struct config config = {};
+	int status;
+	pid_t child;
+
+	config.v[GENE_DEPTH] = 1;
+	config.v[GENE_MOUNTS] = 1;
+
+	child = fork();
+	if (child < 0)
+		return false;
+	if (!child)
+		_exit(add_mounts(&config) ? 1 : 0);
+	waitpid(child, &status, 0);
+	return WIFEXITED(status) && !WEXITSTATUS(status);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = 200, size = 8, top = 5, seed = 0;
+	int opt, ntimes = 20000;
+	char *config_str = NULL;
+	const char *out_dir = NULL;
+
+	while ((opt = getopt(argc, argv, "i:p:n:s:t:o:c:")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 'p':
+			size = atoi(optarg);
+			break;
+		case 'n':
+			ntimes = atoi(optarg);
+			break;
+		case 's':
+			seed = atoi(optarg);
+			break;
+		case 't':
+			top = atoi(optarg);
+			break;
+		case 'o':
+			out_dir = optarg;
+			break;
+		case 'c':
+			config_str = optarg;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || ntimes < BATCHES || size < 2)
+		goto usage;
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+
+	if (create_layout(argv[optind])) {
+		perror("Failed to create the layout");
+		return 1;
+	}
+
+	can_mount = check_mount();
+	if (!can_mount)
+		fprintf(stderr,
+			"Skipping mount crossings (requires CAP_SYS_ADMIN)\n");
+
+	if (config_str) {
+		struct config config;
+
+		if (parse_config(config_str, &config))
+			goto usage;
+		if (remeasure(&config, ntimes)) {
+			fprintf(stderr, "Failed to measure\n");
+			return 1;
+		}
+		print_config("", &config);
+		return 0;
+	}
+
+	rng_state = splitmix64(seed);
+	if (search(iterations, size, top, ntimes, out_dir)) {
+		fprintf(stderr, "Failed to search\n");
+		return 1;
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-i iterations] [-p population] [-n ntimes] [-s seed] [-t top] [-o dir] <dir>\n"
+		"usage: %s [-n ntimes] -c <config> <dir>\n",
+		argv[0], argv[0]);
+	return 1;
+}
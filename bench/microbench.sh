@@ -6,6 +6,18 @@
 # # Run a VM with this new kernel
 # .../microbench.sh vm0 | .../filter-microbench.awk
 #
+# Results can be stored with results-db.sh:
+# .../microbench.sh vm0 | tee >(.../results-db.sh ingest) | .../filter-microbench.awk
+#
+# Set PROFILE=ftrace to replace perf trace with a function_graph profile of
+# Landlock functions (cf. ftrace-landlock.sh), or PROFILE=flamegraph to print
+# folded perf stacks (cf. flamegraph.sh).
+#
+# A calibration (cf. calibrate.c) first measures the timer and null syscall
+# overheads, and the open latency at each depth without and with sandbox, to
+# print the Landlock delta with its error.  It is skipped with a profile, and
+# can be forced on or off with CALIBRATE=1 or CALIBRATE=0.
+#
 # Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
 
 set -e -u -o pipefail
@@ -22,9 +34,24 @@ if [[ $# -gt 1 ]]; then
 fi
 
 SSH_HOST="${1:-}"
+PROFILE="${PROFILE:-}"
+
+# The calibration is only useful to interpret perf trace latencies.
+if [[ -n "${PROFILE}" ]]; then
+	CALIBRATE="${CALIBRATE:-0}"
+else
+	CALIBRATE="${CALIBRATE:-1}"
+fi
 
 BUILD_DIR=".out-landlock_local-x86_64-gcc"
 
+DEPTHS=(
+	/
+	/1/2/3/4/5/6/7/8/9/
+	/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9
+	/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9
+)
+
 get_file() {
 	local path="$1"
 	local basename="./$(basename -- "${path}")"
@@ -54,14 +81,71 @@ if [[ -n "${SSH_HOST}" ]]; then
 fi
 
 get_file "${DIRNAME}/open-ntimes" make -C "${DIRNAME}"
+if [[ "${CALIBRATE}" == 1 ]]; then
+	get_file "${DIRNAME}/calibrate" make -C "${DIRNAME}" calibrate
+fi
 get_file "${DIRNAME}/run-bench-in-namespace.sh"
+case "${PROFILE}" in
+	ftrace)
+		get_file "${DIRNAME}/ftrace-landlock.sh"
+		;;
+	flamegraph)
+		get_file "${DIRNAME}/perf-fold.sh"
+		;;
+esac
 get_file "${BUILD_DIR}/samples/landlock/sandboxer"
 get_file "tools/perf/perf" make -C "tools/perf"
 
+# Identifies the run for results-db.sh.
+echo "[meta] kernel=$(git rev-parse HEAD 2>/dev/null || echo -)"
+echo "[meta] describe=$(git describe --always --dirty 2>/dev/null || echo -)"
+echo "[meta] config=$(sha256sum -- "${BUILD_DIR}/.config" 2>/dev/null | cut -d' ' -f1 || echo -)"
+if [[ -n "${SSH_HOST}" ]]; then
+	echo "[meta] host=${SSH_HOST}"
+	echo "[meta] cpu=$(ssh "${SSH_HOST}" -- sed -n -e "'s/^model name\s*: //p'" /proc/cpuinfo | head -n 1)"
+else
+	echo "[meta] host=$(hostname)"
+	echo "[meta] cpu=$(sed -n -e 's/^model name\s*: //p' /proc/cpuinfo | head -n 1)"
+fi
+echo "[meta] iterations=${NUM_ITERATIONS}"
+echo "[meta] profile=${PROFILE:-perf}"
+
+run_cmd() {
+	if [[ -n "${SSH_HOST}" ]]; then
+		echo "[+] ssh ${SSH_HOST} $*"
+		ssh "${SSH_HOST}" -- "$@"
+	else
+		echo "[+] $*"
+		"$@"
+	fi
+}
+
+run_calibration() {
+	echo "[*] calibration"
+	run_cmd env LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./calibrate -n "${NUM_ITERATIONS}" "${DEPTHS[@]}"
+}
+
 run_test() {
 	local d="$1"
 	local sandboxer="${2:-}"
-	local cmd=(env LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./perf trace -s -e openat -- ${sandboxer} ./open-ntimes "${NUM_ITERATIONS}" 0 "$d")
+	local tracer=(./perf trace -s -e openat --)
+	local cmd
+
+	case "${PROFILE}" in
+		"")
+			;;
+		ftrace)
+			tracer=(./ftrace-landlock.sh)
+			;;
+		flamegraph)
+			tracer=(./perf-fold.sh)
+			;;
+		*)
+			echo "ERROR: Unknown profile: ${PROFILE}" >&2
+			return 1
+			;;
+	esac
+	cmd=(env LL_FS_RO=/ LL_FS_RW=/ IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh "${tracer[@]}" ${sandboxer} ./open-ntimes "${NUM_ITERATIONS}" 0 "$d")
 
 	if [[ -n "${sandboxer}" ]]; then
 		echo -n "[*] with sandbox"
@@ -70,16 +154,14 @@ run_test() {
 	fi
 	echo " d=$d"
 
-	if [[ -n "${SSH_HOST}" ]]; then
-		echo "[+] ssh ${SSH_HOST} ${cmd[*]}"
-		ssh "${SSH_HOST}" -- "${cmd[@]}"
-	else
-		echo "[+] ${cmd[*]}"
-		"${cmd[@]}"
-	fi
+	run_cmd "${cmd[@]}"
 }
 
-for d in / /1/2/3/4/5/6/7/8/9/ /1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9 /1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9; do
+if [[ "${CALIBRATE}" == 1 ]]; then
+	run_calibration 2>&1
+fi
+
+for d in "${DEPTHS[@]}"; do
 	run_test "$d" 2>&1
 	run_test "$d" ./sandboxer 2>&1
 done
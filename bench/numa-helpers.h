@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * NUMA placement helpers for the concurrency benchmarks, without libnuma
+ *
+ * Placements of the workers:
+ * - any: spread over all the allowed CPUs;
+ * - local: on the home node, where the shared state (e.g. a domain or a
+ *   ruleset) is allocated;
+ * - interleave: alternately on each node;
+ * - cross: on the other nodes than the home one.
+ *
+ * Workers are pinned to one CPU, and their memory is bound to the node of
+ * this CPU.  A node with fewer CPUs than workers gets several workers per CPU.
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#ifndef NUMA_HELPERS_H
+#define NUMA_HELPERS_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define NUMA_MAX_NODES 64
+
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#endif
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+enum numa_placement {
+	NUMA_ANY,
+	NUMA_LOCAL,
+	NUMA_INTERLEAVE,
+	NUMA_CROSS,
+	NUMA_NB_PLACEMENTS,
+};
+
+static const char *const numa_placement_names[NUMA_NB_PLACEMENTS] = {
+	[NUMA_ANY] = "any",
+	[NUMA_LOCAL] = "local",
+	[NUMA_INTERLEAVE] = "interleave",
+	[NUMA_CROSS] = "cross",
+};
+
+/* Nodes with allowed CPUs, the first one being the home node. */
+struct numa_nodes {
+	int nb;
+	int ids[NUMA_MAX_NODES];
+	cpu_set_t cpus[NUMA_MAX_NODES];
+	cpu_set_t allowed;
+};
+
+static inline int numa_parse_placement(const char *const name)
+{
+	int i;
+
+	for (i = 0; i < NUMA_NB_PLACEMENTS; i++) {
+		if (!strcmp(name, numa_placement_names[i]))
+			return i;
+	}
+	return -1;
+}
+
+static inline long numa_set_mempolicy(const int mode,
+				      const unsigned long *const nodemask,
+				      const unsigned long maxnode)
+{
+	return syscall(__NR_set_mempolicy, mode, nodemask, maxnode);
+}
+
+/* Parses a CPU list (e.g. "0-3,8-11") into a CPU set. */
+static inline void numa_parse_cpulist(const char *list, cpu_set_t *const set)
+{
+	unsigned int first, last, cpu;
+	int len;
+
+	CPU_ZERO(set);
+	while (sscanf(list, "%u%n", &first, &len) == 1) {
+		list += len;
+		last = first;
+		if (*list == '-' && sscanf(list + 1, "%u%n", &last, &len) == 1)
+			list += 1 + len;
+		for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, set);
+		if (*list != ',')
+			break;
+		list++;
+	}
+}
+
+/*
+ * Reads the NUMA nodes from sysfs, only keeping the allowed CPUs.  Without
+ * NUMA support, all the allowed CPUs are in one node.
+ */
+static inline int numa_read_nodes(struct numa_nodes *const nodes)
+{
+	char path[64], list[4096];
+	cpu_set_t cpus;
+	FILE *f;
+	int id;
+
+	memset(nodes, 0, sizeof(*nodes));
+	if (sched_getaffinity(0, sizeof(nodes->allowed), &nodes->allowed))
+		return -1;
+
+	for (id = 0; id < NUMA_MAX_NODES; id++) {
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/node/node%d/cpulist", id);
+		f = fopen(path, "re");
+		if (!f)
+			continue;
+		if (!fgets(list, sizeof(list), f))
+			list[0] = '\0';
+		fclose(f);
+
+		numa_parse_cpulist(list, &cpus);
+		CPU_AND(&cpus, &cpus, &nodes->allowed);
+		if (!CPU_COUNT(&cpus))
+			continue;
+		nodes->ids[nodes->nb] = id;
+		nodes->cpus[nodes->nb] = cpus;
+		nodes->nb++;
+	}
+
+	if (!nodes->nb) {
+		nodes->ids[0] = 0;
+		nodes->cpus[0] = nodes->allowed;
+		nodes->nb = 1;
+	}
+	return 0;
+}
+
+/* Pins the calling thread to the index-th CPU of a set. */
+static inline int numa_pin_cpu(const cpu_set_t *const cpus,
+			       const unsigned int index)
+{
+	const unsigned int target = index % CPU_COUNT(cpus);
+	unsigned int cpu, n = 0;
+	cpu_set_t set;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, cpus) && n++ == target)
+			break;
+	}
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set);
+}
+
+/* Pins the calling thread to a CPU of a node, and binds its memory there. */
+static inline int numa_pin_node(const struct numa_nodes *const nodes,
+				const int node, const unsigned int index)
+{
+	const unsigned long nodemask = 1UL << nodes->ids[node];
+
+	if (numa_pin_cpu(&nodes->cpus[node], index))
+		return -1;
+	/* Fails without CONFIG_NUMA, in which case there is only one node. */
+	if (numa_set_mempolicy(MPOL_BIND, &nodemask, NUMA_MAX_NODES + 1) &&
+	    nodes->nb > 1)
+		return -1;
+	return 0;
+}
+
+/* Places the calling thread on the home node, to allocate shared state. */
+static inline int numa_pin_home(const struct numa_nodes *const nodes)
+{
+	return numa_pin_node(nodes, 0, 0);
+}
+
+/* Undoes numa_pin_home(). */
+static inline int numa_unpin(const struct numa_nodes *const nodes)
+{
+	if (sched_setaffinity(0, sizeof(nodes->allowed), &nodes->allowed))
+		return -1;
+	numa_set_mempolicy(MPOL_DEFAULT, NULL, 0);
+	return 0;
+}
+
+/* Places the calling thread as the index-th worker. */
+static inline int numa_pin_worker(const struct numa_nodes *const nodes,
+				  const enum numa_placement placement,
+				  const unsigned int index)
+{
+	switch (placement) {
+	case NUMA_LOCAL:
+		return numa_pin_node(nodes, 0, index);
+	case NUMA_INTERLEAVE:
+		return numa_pin_node(nodes, index % nodes->nb,
+				     index / nodes->nb);
+	case NUMA_CROSS:
+		if (nodes->nb < 2)
+			return -1;
+		return numa_pin_node(nodes, 1 + index % (nodes->nb - 1),
+				     index / (nodes->nb - 1));
+	default:
+		return numa_pin_cpu(&nodes->allowed, index);
+	}
+}
+
+#endif /* NUMA_HELPERS_H */
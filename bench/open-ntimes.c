@@ -11,12 +11,14 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 
 int main(int argc, char *argv[]) {
 	ssize_t ntimes;
 	int err;
 	const char *path;
+	struct timespec start, end;
 
 	if (argc != 4)
 		return 1;
@@ -32,6 +34,7 @@ int main(int argc, char *argv[]) {
 	path = argv[3];
 	printf("path: %s\n", path);
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	for (size_t i = 0; i < ntimes; i++) {
 		int fd = open(path, O_RDONLY);
 		if (fd < 0) {
@@ -50,5 +53,11 @@ int main(int argc, char *argv[]) {
 			printf("i: %ld\n", i);
 		}
 	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	/* Used when perf is not available (e.g. UML). */
+	printf("ns/op: %.1f\n",
+	       ((end.tv_sec - start.tv_sec) * 1e9 +
+		(end.tv_nsec - start.tv_nsec)) / ntimes);
 	return 0;
 }
@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run a command while sampling its kernel and user stacks with perf, and print
+# them folded (one "[folded] <frame;frame;...> <count>" line per stack), the
+# root frame being the command name.  Kernel frames have a "_[k]" suffix.
+#
+# Used by flamegraph.sh through microbench.sh, because the perf data is lost
+# when the benchmark namespace is left.
+#
+# ./perf-fold.sh ./sandboxer ./open-ntimes 100000 0 /1/2/3/4/5/6/7/8/9
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -u -e -o pipefail
+
+if [[ $# -lt 1 ]]; then
+	echo "usage: $(basename -- "${BASH_SOURCE[0]}") <command> [arg]..." >&2
+	exit 1
+fi
+
+PERF="${PERF:-./perf}"
+FREQUENCY="${FREQUENCY:-4999}"
+
+DATA="$(mktemp -p . .perf-fold.XXXXXXXXXX)"
+
+cleanup() {
+	rm -- "${DATA}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+RET=0
+"${PERF}" record --quiet -F "${FREQUENCY}" -g -o "${DATA}" -- "$@" || RET=$?
+
+# perf script output:
+#
+# open-ntimes  3115 1234.567890:     250000 cycles:P:
+# 	ffffffff8123abcd find_rule+0x2d ([kernel.kallsyms])
+# 	ffffffff8123bcde is_access_to_paths_allowed+0x1fe ([kernel.kallsyms])
+# 	    7f0123456789 __open64+0x59 (/usr/lib/libc.so.6)
+#
+"${PERF}" script -i "${DATA}" 2>/dev/null | awk '
+function flush(    stack, i) {
+	if (comm == "") {
+		return
+	}
+	stack = comm
+	for (i = n; i >= 1; i--) {
+		stack = stack ";" frames[i]
+	}
+	counts[stack]++
+	comm = ""
+	n = 0
+}
+
+/^[^ \t]/ {
+	flush()
+	comm = $1
+	next
+}
+
+/^[ \t]+[0-9a-f]+ / {
+	sym = $2
+	sub(/\+0x[0-9a-f]+$/, "", sym)
+	if ($NF == "([kernel.kallsyms])") {
+		sym = sym "_[k]"
+	}
+	frames[++n] = sym
+	next
+}
+
+/^[ \t]*$/ {
+	flush()
+}
+
+END {
+	flush()
+	for (stack in counts) {
+		print "[folded] " stack " " counts[stack]
+	}
+}'
+
+exit "${RET}"
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * policy-bench [-n rounds] <policy-file> <path-list>
+ *
+ * Measure the cost of a Landlock policy: the latency of opening each path of a
+ * list without and with the policy enforced.
+ *
+ * The policy file has one "<rights> <path>" rule per line, with rights being
+ * "ro", "rw" (as for the sandboxer's LL_FS_RO and LL_FS_RW) or a
+ * comma-separated list of access right names (e.g. "read_file,truncate").
+ *
+ * The kernel memory used by a ruleset is not measured: the system-wide slab
+ * usage is too noisy to show a difference of a few rules, so the number of
+ * rules is printed instead.
+ *
+ * ./policy-bench policy /mnt/tree.list
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+struct rule {
+	__u64 access;
+	char *path;
+};
+
+struct policy {
+	struct rule *rules;
+	size_t len;
+	__u64 handled;
+};
+
+static const struct {
+	const char *name;
+	__u64 access;
+} access_names[] = {
+	{ "ro", LL_ACCESS_FS_ROUGHLY_READ },
+	{ "rw", LL_ACCESS_FS_ROUGHLY_READ | LL_ACCESS_FS_ROUGHLY_WRITE },
+	{ "execute", LANDLOCK_ACCESS_FS_EXECUTE },
+	{ "write_file", LANDLOCK_ACCESS_FS_WRITE_FILE },
+	{ "read_file", LANDLOCK_ACCESS_FS_READ_FILE },
+	{ "read_dir", LANDLOCK_ACCESS_FS_READ_DIR },
+	{ "remove_dir", LANDLOCK_ACCESS_FS_REMOVE_DIR },
+	{ "remove_file", LANDLOCK_ACCESS_FS_REMOVE_FILE },
+	{ "make_char", LANDLOCK_ACCESS_FS_MAKE_CHAR },
+	{ "make_dir", LANDLOCK_ACCESS_FS_MAKE_DIR },
+	{ "make_reg", LANDLOCK_ACCESS_FS_MAKE_REG },
+	{ "make_sock", LANDLOCK_ACCESS_FS_MAKE_SOCK },
+	{ "make_fifo", LANDLOCK_ACCESS_FS_MAKE_FIFO },
+	{ "make_block", LANDLOCK_ACCESS_FS_MAKE_BLOCK },
+	{ "make_sym", LANDLOCK_ACCESS_FS_MAKE_SYM },
+	{ "refer", LANDLOCK_ACCESS_FS_REFER },
+	{ "truncate", LANDLOCK_ACCESS_FS_TRUNCATE },
+	{ "ioctl_dev", LANDLOCK_ACCESS_FS_IOCTL_DEV },
+};
+
+static int parse_access(char *const str, __u64 *const access)
+{
+	char *token, *saveptr = NULL, *list;
+	size_t i;
+
+	*access = 0;
+	for (list = str; (token = strtok_r(list, ",", &saveptr)); list = NULL) {
+		for (i = 0; i < sizeof(access_names) / sizeof(access_names[0]);
+		     i++) {
+			if (!strcmp(token, access_names[i].name))
+				break;
+		}
+		if (i == sizeof(access_names) / sizeof(access_names[0])) {
+			fprintf(stderr, "Unknown access right: %s\n", token);
+			return -1;
+		}
+		*access |= access_names[i].access;
+	}
+	return 0;
+}
+
+static int load_policy(const char *const file, struct policy *const policy)
+{
+	FILE *const in = fopen(file, "r");
+	char *line = NULL, *sep;
+	size_t size = 0;
+	ssize_t len;
+	int err = 0;
+
+	if (!in) {
+		perror("Failed to open the policy");
+		return -1;
+	}
+
+	memset(policy, 0, sizeof(*policy));
+	while (!err && (len = getline(&line, &size, in)) >= 0) {
+		struct rule *rules;
+
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len || line[0] == '#')
+			continue;
+
+		sep = strchr(line, ' ');
+		if (!sep) {
+			fprintf(stderr, "Invalid rule: %s\n", line);
+			err = -1;
+			break;
+		}
+		*sep = '\0';
+
+		rules = realloc(policy->rules,
+				(policy->len + 1) * sizeof(*policy->rules));
+		if (!rules) {
+			err = -1;
+			break;
+		}
+		policy->rules = rules;
+		rules[policy->len].path = strdup(sep + 1);
+		err = parse_access(line, &rules[policy->len].access);
+		if (!rules[policy->len].path)
+			err = -1;
+		if (!err)
+			policy->handled |= rules[policy->len++].access;
+	}
+	free(line);
+	fclose(in);
+	return err;
+}
+
+static int create_ruleset(const struct policy *const policy)
+{
+	const int ruleset_fd = ll_create_ruleset(policy->handled);
+	size_t i;
+
+	if (ruleset_fd < 0)
+		return -1;
+
+	for (i = 0; i < policy->len; i++) {
+		if (ll_add_path(ruleset_fd, policy->rules[i].path,
+				policy->rules[i].access)) {
+			fprintf(stderr, "Failed to add rule for \"%s\": %s\n",
+				policy->rules[i].path, strerror(errno));
+			close(ruleset_fd);
+			return -1;
+		}
+	}
+	return ruleset_fd;
+}
+
+struct path_list {
+	char **paths;
+	size_t len;
+};
+
+static int load_paths(const char *const file, struct path_list *const list)
+{
+	FILE *const in = fopen(file, "r");
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+
+	if (!in) {
+		perror("Failed to open the path list");
+		return -1;
+	}
+
+	memset(list, 0, sizeof(*list));
+	while ((len = getline(&line, &size, in)) >= 0) {
+		char **paths;
+
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len)
+			continue;
+
+		paths = realloc(list->paths,
+				(list->len + 1) * sizeof(*list->paths));
+		if (!paths)
+			break;
+		list->paths = paths;
+		paths[list->len] = strdup(line);
+		if (!paths[list->len])
+			break;
+		list->len++;
+	}
+	free(line);
+	fclose(in);
+	return 0;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Opens all the paths in a child process, which may be sandboxed, and returns
+ * the average latency in nanoseconds.
+ */
+static double measure_latency(const struct policy *const policy,
+			      const struct path_list *const list,
+			      const int rounds, const bool sandboxed,
+			      unsigned long long *const denied)
+{
+	struct {
+		double ns;
+		unsigned long long denied;
+	} result = {};
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC))
+		return -1;
+
+	child = fork();
+	if (child < 0)
+		return -1;
+	if (!child) {
+		unsigned long long start;
+		size_t i;
+		int r, fd;
+
+		close(pipefd[0]);
+		if (sandboxed) {
+			fd = create_ruleset(policy);
+			if (fd < 0 || ll_restrict(fd)) {
+				perror("Failed to sandbox");
+				_exit(1);
+			}
+			close(fd);
+		}
+
+		start = now_ns();
+		for (r = 0; r < rounds; r++) {
+			for (i = 0; i < list->len; i++) {
+				fd = open(list->paths[i], O_RDONLY | O_CLOEXEC);
+				if (fd >= 0)
+					close(fd);
+				else if (!r && errno == EACCES)
+					result.denied++;
+			}
+		}
+		result.ns = (double)(now_ns() - start) / rounds / list->len;
+		if (write(pipefd[1], &result, sizeof(result)) != sizeof(result))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], &result, sizeof(result)) == sizeof(result);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	*denied = result.denied;
+	return result.ns;
+}
+
+int main(int argc, char *argv[])
+{
+	struct policy policy;
+	struct path_list list;
+	int opt, rounds = 10;
+	double base, sandboxed;
+	unsigned long long denied;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			rounds = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 2 || rounds <= 0)
+		goto usage;
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+	if (load_policy(argv[optind], &policy))
+		return 1;
+
+	printf("[policy] rules=%zu\n", policy.len);
+
+	if (load_paths(argv[optind + 1], &list))
+		return 1;
+	if (!list.len) {
+		fprintf(stderr, "Empty path list\n");
+		return 1;
+	}
+
+	base = measure_latency(&policy, &list, rounds, false, &denied);
+	sandboxed = measure_latency(&policy, &list, rounds, true, &denied);
+	if (base < 0 || sandboxed < 0) {
+		fprintf(stderr, "Failed to measure the latency\n");
+		return 1;
+	}
+	printf("[policy] paths=%zu denied=%llu base=%.1f sandbox=%.1f\n",
+	       list.len, denied, base, sandboxed);
+	return 0;
+
+usage:
+	fprintf(stderr, "usage: %s [-n rounds] <policy-file> <path-list>\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,285 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Minimize a Landlock filesystem policy without changing its semantics, and
+# optionally measure its cost before and after with policy-bench.
+#
+# The policy has one "<rights> <path>" rule per line (cf. policy-bench.c), or
+# is read from LL_FS_RO and LL_FS_RW (as for the sandboxer) if no file is
+# given.  Paths are resolved, then:
+# - rules on the same file or directory are merged;
+# - rules granting a subset of the access rights already granted by rules on
+#   their parent directories are removed, unless the file or directory may be
+#   reachable through other paths (bind mounts, hard links).
+#
+# The minimized policy is printed on stdout, as rules or with -e as
+# LL_FS_RO/LL_FS_RW variables.  The result is only valid for the current
+# filesystem and mount layout.
+#
+# .../policy-minimize.sh policy > policy.min
+# LL_FS_RO=/usr:/usr/lib:/etc LL_FS_RW=/tmp .../policy-minimize.sh -e
+# .../policy-minimize.sh -b paths.list policy > policy.min
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+DIRNAME="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+usage() {
+	echo "usage: ${BASENAME} [-e] [-b path-list] [policy-file]" >&2
+	exit 1
+}
+
+ENV_FORMAT=0
+BENCH_PATHS=""
+
+while getopts "eb:" opt; do
+	case "${opt}" in
+		e)
+			ENV_FORMAT=1
+			;;
+		b)
+			BENCH_PATHS="${OPTARG}"
+			;;
+		*)
+			usage
+			;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [[ $# -gt 1 ]]; then
+	usage
+fi
+
+POLICY="${1:-}"
+
+# Prints the input policy as "<rights> <path>" lines.
+read_policy() {
+	local path
+
+	if [[ -n "${POLICY}" ]]; then
+		grep -v -e '^\s*\(#\|$\)' -- "${POLICY}"
+		return
+	fi
+
+	local -a ro rw
+	IFS=: read -r -a ro <<< "${LL_FS_RO:-}"
+	IFS=: read -r -a rw <<< "${LL_FS_RW:-}"
+	for path in "${ro[@]}"; do
+		if [[ -n "${path}" ]]; then
+			echo "ro ${path}"
+		fi
+	done
+	for path in "${rw[@]}"; do
+		if [[ -n "${path}" ]]; then
+			echo "rw ${path}"
+		fi
+	done
+}
+
+# Prints tab-separated rules with their resolved path, file type, number of
+# links, and device.
+resolve_policy() {
+	local rights path resolved info
+
+	while read -r rights path; do
+		if ! resolved="$(realpath -e -- "${path}" 2>/dev/null)" ||
+			! info="$(stat -c '%F	%h	%Hd:%Ld' -- "${resolved}" 2>/dev/null)"; then
+			echo "WARNING: Ignoring rule for missing path: ${path}" >&2
+			continue
+		fi
+		printf '%s\t%s\t%s\n' "${rights}" "${resolved}" "${info}"
+	done
+}
+
+minimize() {
+	awk -F '\t' -v env_format="${ENV_FORMAT}" '
+	BEGIN {
+		nb_rights = split("execute write_file read_file read_dir remove_dir remove_file make_char make_dir make_reg make_sock make_fifo make_block make_sym refer truncate ioctl_dev", right_names, " ")
+		split("execute read_file read_dir", tmp, " ")
+		for (i in tmp) {
+			ro[tmp[i]] = 1
+		}
+		for (i = 1; i <= nb_rights; i++) {
+			rw[right_names[i]] = 1
+		}
+		split("execute write_file read_file truncate ioctl_dev", tmp, " ")
+		for (i in tmp) {
+			file_right[tmp[i]] = 1
+		}
+	}
+
+	function depth(path,    parts) {
+		return path == "/" ? 0 : split(path, parts, "/") - 1
+	}
+
+	function parent(path) {
+		sub(/\/[^\/]*$/, "", path)
+		return path == "" ? "/" : path
+	}
+
+	# Adds the rights of a rule to a path, only file rights for files.
+	function add_rights(path, rights, is_dir,    names, parts, i) {
+		if (rights == "ro" || rights == "rw") {
+			for (i = 1; i <= nb_rights; i++) {
+				if (rights == "rw" || right_names[i] in ro) {
+					names = names "," right_names[i]
+				}
+			}
+			rights = substr(names, 2)
+		}
+		split(rights, parts, ",")
+		for (i in parts) {
+			if (!(parts[i] in rw)) {
+				printf("ERROR: Unknown access right: %s\n", parts[i]) > "/dev/stderr"
+				exit 1
+			}
+			if (is_dir || file_right[parts[i]]) {
+				granted[path, parts[i]] = 1
+			}
+		}
+	}
+
+	# Formats the rights of a path, as ro or rw if they match.
+	function format_rights(path, is_dir,    i, r, list, is_ro, is_rw) {
+		is_ro = is_rw = 1
+		for (i = 1; i <= nb_rights; i++) {
+			r = right_names[i]
+			if (!is_dir && !file_right[r]) {
+				continue
+			}
+			if ((path, r) in granted) {
+				list = list "," r
+			}
+			if (((path, r) in granted) != (r in ro)) {
+				is_ro = 0
+			}
+			if (!((path, r) in granted)) {
+				is_rw = 0
+			}
+		}
+		return is_ro ? "ro" : is_rw ? "rw" : substr(list, 2)
+	}
+
+	# Mount points, from mountinfo.
+	FILENAME != "-" {
+		split($0, fields, " ")
+		mounts[fields[3]]++
+		next
+	}
+
+	{
+		nb_input++
+		path = $2
+		is_dir = ($3 == "directory")
+		if (!(path in type)) {
+			paths[++nb_paths] = path
+		} else {
+			merged++
+		}
+		type[path] = is_dir
+		# Unique if not hard linked and on a filesystem mounted once.
+		unique[path] = (is_dir || $4 == 1) && mounts[$5] == 1
+		add_rights(path, $1, is_dir)
+	}
+
+	END {
+		# Sorts by depth, to process parents first.
+		for (i = 1; i <= nb_paths; i++) {
+			for (j = i; j > 1 && depth(paths[j - 1]) > depth(paths[j]); j--) {
+				swap = paths[j]
+				paths[j] = paths[j - 1]
+				paths[j - 1] = swap
+			}
+		}
+
+		for (i = 1; i <= nb_paths; i++) {
+			path = paths[i]
+			if (!unique[path] || path == "/") {
+				kept[path] = 1
+				continue
+			}
+
+			# Rights already granted by kept rules on parent directories.
+			redundant = 1
+			for (n = 1; n <= nb_rights && redundant; n++) {
+				r = right_names[n]
+				if (!((path, r) in granted)) {
+					continue
+				}
+				covered = 0
+				for (p = parent(path); !covered; p = parent(p)) {
+					if ((p in kept) && ((p, r) in granted)) {
+						covered = 1
+					}
+					if (p == "/") {
+						break
+					}
+				}
+				redundant = covered
+			}
+			if (redundant) {
+				removed++
+			} else {
+				kept[path] = 1
+			}
+		}
+
+		for (i = 1; i <= nb_paths; i++) {
+			path = paths[i]
+			if (!(path in kept)) {
+				continue
+			}
+			nb_output++
+			rights = format_rights(path, type[path])
+			if (!env_format) {
+				print rights " " path
+			} else if (rights == "ro") {
+				env_ro = env_ro ":" path
+			} else if (rights == "rw") {
+				env_rw = env_rw ":" path
+			} else {
+				printf("ERROR: Rule not expressible with LL_FS_RO or LL_FS_RW: %s %s\n", rights, path) > "/dev/stderr"
+				exit 1
+			}
+		}
+		if (env_format) {
+			printf("LL_FS_RO=%s LL_FS_RW=%s\n", substr(env_ro, 2), substr(env_rw, 2))
+		}
+		printf("[*] %d rules: %d merged, %d redundant, %d remaining\n", nb_input, merged, removed, nb_output) > "/dev/stderr"
+	}' /proc/self/mountinfo -
+}
+
+bench() {
+	local name="$1"
+	local policy="$2"
+
+	"${DIRNAME}/policy-bench" "${policy}" "${BENCH_PATHS}" \
+		| sed -e "s/^\[policy\]/[policy] ${name}/" >&2
+}
+
+RESOLVED="$(mktemp)"
+INPUT="$(mktemp)"
+OUTPUT="$(mktemp)"
+trap 'rm -f -- "${RESOLVED}" "${INPUT}" "${OUTPUT}"' EXIT
+
+read_policy | resolve_policy > "${RESOLVED}"
+minimize < "${RESOLVED}" > "${OUTPUT}"
+cat -- "${OUTPUT}"
+
+if [[ -n "${BENCH_PATHS}" ]]; then
+	if [[ ! -x "${DIRNAME}/policy-bench" ]]; then
+		echo "ERROR: Missing ${DIRNAME}/policy-bench (cf. make policy-bench)" >&2
+		exit 1
+	fi
+	if [[ "${ENV_FORMAT}" -eq 1 ]]; then
+		ENV_FORMAT=0 minimize < "${RESOLVED}" > "${OUTPUT}" 2>/dev/null
+	fi
+	# Compares with the rules minimize started from, without missing paths.
+	cut -f1,2 -- "${RESOLVED}" | tr '\t' ' ' > "${INPUT}"
+	bench before "${INPUT}"
+	bench after "${OUTPUT}"
+fi
@@ -0,0 +1,666 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * rename-storm [-m readers] [-k renamers[,renamers]...] [-d depth]
+ *              [-t seconds] [-p function[,function]...]
+ *              [-N placement[,placement]...] <dir>
+ *
+ * Measure the latency of open(2) on a file at the bottom of a directory chain
+ * while other threads continuously rename the intermediate directories, which
+ * invalidates the RCU path walks in flight.
+ *
+ * For each number of renamers, M reader threads open the file in a loop for
+ * the given duration, first without sandbox and then each with its own
+ * Landlock domain allowing to read the top of the chain.  The renamers are not
+ * sandboxed, and each of them renames a random directory of the chain back
+ * and forth through a file descriptor on its parent.  Opens failing with
+ * ENOENT (i.e. during a rename) are counted but not included in the latency
+ * percentiles, which have a precision of about 6%.
+ *
+ * With -p, kprobes are set on the given kernel functions, and their number of
+ * hits per open is printed as "[trace]" lines.  These counters are system-wide
+ * and require write access to tracefs.  Probing both do_filp_open and
+ * path_openat gives the ratio of path walks retried without RCU or with
+ * LOOKUP_REVAL.  Functions that cannot be probed (e.g. inlined) are ignored.
+ *
+ * With -N, the readers are placed on the NUMA nodes according to each
+ * placement (cf. numa-helpers.h), and the ruleset is created on the home
+ * node.  The renamers are not pinned.
+ *
+ * The directory chain is created in <dir>, e.g. in the tmpfs /tmp provided by
+ * run-bench-in-namespace.sh:
+ *
+ * IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./rename-storm -m 4 -k 0,1,4 -p do_filp_open,path_openat,try_to_unlazy /tmp
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+#include "numa-helpers.h"
+
+#define MAX_DEPTH 64
+#define MAX_RENAMERS 16
+#define MAX_THREADS 1024
+#define MAX_PROBES 16
+#define MAX_PLACEMENTS 8
+
+/* Log-linear latency histogram: 16 buckets per power of two. */
+#define SUB_BITS 4
+#define SUB (1U << SUB_BITS)
+#define NB_BUCKETS ((64 - SUB_BITS + 1) * SUB)
+
+#define PROBE_GROUP "rename_storm"
+#define PROBE_INSTANCE "rename-storm"
+
+struct storm {
+	const char *path;
+	unsigned int depth;
+	/* parents[i] is a file descriptor on the parent of level i. */
+	int parents[MAX_DEPTH + 1];
+	int ruleset_fd;
+	enum numa_placement placement;
+	int stop;
+	pthread_barrier_t barrier;
+};
+
+struct reader {
+	pthread_t tid;
+	struct storm *storm;
+	unsigned int index;
+	unsigned long long hist[NB_BUCKETS];
+	unsigned long long opens;
+	unsigned long long enoent;
+	unsigned long long errors;
+	unsigned long long max_ns;
+	int err;
+};
+
+struct renamer {
+	pthread_t tid;
+	struct storm *storm;
+	uint64_t rng_state;
+	unsigned long long renames;
+};
+
+static char top[PATH_MAX];
+static const char *tracing;
+static char probes[MAX_PROBES][64];
+static unsigned int nb_probes;
+static struct numa_nodes nodes;
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned int bucket(const unsigned long long ns)
+{
+	unsigned int msb;
+
+	if (ns < SUB)
+		return ns;
+	msb = 63 - __builtin_clzll(ns);
+	return (msb - SUB_BITS + 1) * SUB + ((ns >> (msb - SUB_BITS)) & (SUB - 1));
+}
+
+/* Returns the lower bound of a bucket, in nanoseconds. */
+static unsigned long long bucket_ns(const unsigned int index)
+{
+	unsigned int msb;
+
+	if (index < SUB)
+		return index;
+	msb = index / SUB + SUB_BITS - 1;
+	return (unsigned long long)(SUB + index % SUB) << (msb - SUB_BITS);
+}
+
+static unsigned long long percentile(const unsigned long long *const hist,
+				     const unsigned long long total,
+				     const double p)
+{
+	const unsigned long long target = p * total + 0.5;
+	unsigned long long sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < NB_BUCKETS; i++) {
+		sum += hist[i];
+		if (sum >= target && sum)
+			return bucket_ns(i);
+	}
+	return 0;
+}
+
+/*
+ * Creates <dir>/rename-storm/1/2/.../<depth>/file, restores the directories
+ * left renamed by an interrupted run, and opens the parent of each level.
+ */
+static int create_chain(const char *const dir, struct storm *const storm)
+{
+	char path[PATH_MAX], name[16], renamed[16];
+	unsigned int i;
+	int fd;
+
+	if (snprintf(top, sizeof(top), "%s/rename-storm", dir) >= sizeof(top))
+		return -1;
+	if (mkdir(top, 0755) && errno != EEXIST)
+		return -1;
+
+	storm->parents[1] = open(top, O_PATH | O_DIRECTORY | O_CLOEXEC);
+	if (storm->parents[1] < 0)
+		return -1;
+
+	for (i = 1; i <= storm->depth; i++) {
+		snprintf(name, sizeof(name), "%u", i);
+		snprintf(renamed, sizeof(renamed), "%u.r", i);
+		if (renameat(storm->parents[i], renamed, storm->parents[i],
+			     name) &&
+		    errno != ENOENT)
+			return -1;
+		if (mkdirat(storm->parents[i], name, 0755) && errno != EEXIST)
+			return -1;
+		if (i == storm->depth)
+			break;
+		storm->parents[i + 1] = openat(storm->parents[i], name,
+					       O_PATH | O_DIRECTORY | O_CLOEXEC);
+		if (storm->parents[i + 1] < 0)
+			return -1;
+	}
+
+	snprintf(path, sizeof(path), "%s", top);
+	for (i = 1; i <= storm->depth; i++) {
+		if (snprintf(path + strlen(path), sizeof(path) - strlen(path),
+			     "/%u", i) >= sizeof(path) - strlen(path))
+			return -1;
+	}
+	if (snprintf(path + strlen(path), sizeof(path) - strlen(path),
+		     "/file") >= sizeof(path) - strlen(path))
+		return -1;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -1;
+	close(fd);
+
+	storm->path = strdup(path);
+	return storm->path ? 0 : -1;
+}
+
+static int create_ruleset(void)
+{
+	const int ruleset_fd = ll_create_ruleset(LL_ACCESS_FS_ROUGHLY_READ);
+
+	if (ruleset_fd < 0)
+		return -1;
+	if (ll_add_path(ruleset_fd, top, LL_ACCESS_FS_ROUGHLY_READ)) {
+		close(ruleset_fd);
+		return -1;
+	}
+	return ruleset_fd;
+}
+
+static void *read_worker(void *const arg)
+{
+	struct reader *const reader = arg;
+	struct storm *const storm = reader->storm;
+	unsigned long long start, ns;
+	int fd;
+
+	/* Only places and sandboxes this thread. */
+	if (storm->placement != NUMA_ANY &&
+	    numa_pin_worker(&nodes, storm->placement, reader->index))
+		reader->err = errno;
+	else if (storm->ruleset_fd >= 0 && ll_restrict(storm->ruleset_fd))
+		reader->err = errno;
+	pthread_barrier_wait(&storm->barrier);
+	if (reader->err)
+		return NULL;
+
+	while (!__atomic_load_n(&storm->stop, __ATOMIC_RELAXED)) {
+		start = now_ns();
+		fd = open(storm->path, O_RDONLY | O_CLOEXEC);
+		ns = now_ns() - start;
+		if (fd < 0) {
+			if (errno == ENOENT)
+				reader->enoent++;
+			else
+				reader->errors++;
+			continue;
+		}
+		close(fd);
+		reader->opens++;
+		reader->hist[bucket(ns)]++;
+		if (ns > reader->max_ns)
+			reader->max_ns = ns;
+	}
+	return NULL;
+}
+
+static void *rename_worker(void *const arg)
+{
+	struct renamer *const renamer = arg;
+	struct storm *const storm = renamer->storm;
+	char name[16], renamed[16];
+	unsigned int level;
+	int parent_fd;
+
+	pthread_barrier_wait(&storm->barrier);
+
+	while (!__atomic_load_n(&storm->stop, __ATOMIC_RELAXED)) {
+		renamer->rng_state = splitmix64(renamer->rng_state);
+		level = 1 + renamer->rng_state % storm->depth;
+		parent_fd = storm->parents[level];
+		snprintf(name, sizeof(name), "%u", level);
+		snprintf(renamed, sizeof(renamed), "%u.r", level);
+
+		/* Another renamer may currently hold this level. */
+		if (renameat(parent_fd, name, parent_fd, renamed))
+			continue;
+		if (renameat(parent_fd, renamed, parent_fd, name)) {
+			perror("Failed to restore a renamed directory");
+			exit(1);
+		}
+		renamer->renames += 2;
+	}
+	return NULL;
+}
+
+static int write_file(const char *const name, const char *const value,
+		      const int flags)
+{
+	char path[PATH_MAX];
+	ssize_t len;
+	int fd, err;
+
+	snprintf(path, sizeof(path), "%s/%s", tracing, name);
+	fd = open(path, O_WRONLY | O_CLOEXEC | flags);
+	if (fd < 0)
+		return -1;
+	len = write(fd, value, strlen(value));
+	err = len == strlen(value) ? 0 : errno ? errno : EIO;
+	close(fd);
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Adds a kprobe event for each function, enabled in a dedicated tracing
+ * instance which doesn't record anything: only the hit counters are used.
+ */
+static int setup_probes(char *const list)
+{
+	char path[PATH_MAX], def[256], *func, *saveptr = NULL;
+
+	tracing = "/sys/kernel/tracing";
+	snprintf(path, sizeof(path), "%s/kprobe_events", tracing);
+	if (access(path, W_OK)) {
+		tracing = "/sys/kernel/debug/tracing";
+		snprintf(path, sizeof(path), "%s/kprobe_events", tracing);
+		if (access(path, W_OK)) {
+			fprintf(stderr, "ERROR: Kprobe events are not available\n");
+			return -1;
+		}
+	}
+
+	snprintf(path, sizeof(path), "%s/instances/%s", tracing,
+		 PROBE_INSTANCE);
+	if (mkdir(path, 0755) && errno != EEXIST) {
+		perror("Failed to create the tracing instance");
+		return -1;
+	}
+	if (write_file("instances/" PROBE_INSTANCE "/tracing_on", "0", 0)) {
+		perror("Failed to disable the tracing instance");
+		return -1;
+	}
+
+	for (func = strtok_r(list, ",", &saveptr); func;
+	     func = strtok_r(NULL, ",", &saveptr)) {
+		if (nb_probes >= MAX_PROBES ||
+		    strlen(func) >= sizeof(probes[0]) - 3)
+			return -1;
+
+		snprintf(def, sizeof(def), "p:%s/rs_%s %s\n", PROBE_GROUP,
+			 func, func);
+		if (write_file("kprobe_events", def, O_APPEND)) {
+			fprintf(stderr, "WARNING: Cannot probe %s: %s\n", func,
+				strerror(errno));
+			continue;
+		}
+		snprintf(probes[nb_probes], sizeof(probes[0]), "rs_%s", func);
+		snprintf(path, sizeof(path),
+			 "instances/%s/events/%s/%s/enable", PROBE_INSTANCE,
+			 PROBE_GROUP, probes[nb_probes]);
+		nb_probes++;
+		if (write_file(path, "1", 0)) {
+			fprintf(stderr, "ERROR: Failed to enable %s: %s\n",
+				func, strerror(errno));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void cleanup_probes(void)
+{
+	char path[PATH_MAX], def[128];
+	unsigned int i;
+
+	if (!tracing)
+		return;
+
+	for (i = 0; i < nb_probes; i++) {
+		snprintf(path, sizeof(path),
+			 "instances/%s/events/%s/%s/enable", PROBE_INSTANCE,
+			 PROBE_GROUP, probes[i]);
+		write_file(path, "0", 0);
+	}
+	snprintf(path, sizeof(path), "%s/instances/%s", tracing,
+		 PROBE_INSTANCE);
+	rmdir(path);
+	for (i = 0; i < nb_probes; i++) {
+		snprintf(def, sizeof(def), "-:%s/%s\n", PROBE_GROUP, probes[i]);
+		write_file("kprobe_events", def, O_APPEND);
+	}
+}
+
+/* Reads the cumulative hit counters of the probes. */
+static int read_probes(unsigned long long *const hits)
+{
+	char path[PATH_MAX], name[128];
+	unsigned long long nhit, nmissed;
+	unsigned int i;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/kprobe_profile", tracing);
+	f = fopen(path, "re");
+	if (!f)
+		return -1;
+	while (fscanf(f, "%127s %llu %llu", name, &nhit, &nmissed) == 3) {
+		for (i = 0; i < nb_probes; i++) {
+			const char *const event = strchr(name, '/');
+
+			if (!strcmp(event ? event + 1 : name, probes[i]))
+				hits[i] = nhit;
+		}
+	}
+	fclose(f);
+	return 0;
+}
+
+static int find_probe(const char *const func)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_probes; i++) {
+		if (!strcmp(probes[i] + 3, func))
+			return i;
+	}
+	return -1;
+}
+
+static int run(struct storm *const storm, const unsigned int nb_readers,
+	       const unsigned int nb_renamers, const unsigned int seconds,
+	       const char *const mode)
+{
+	static struct reader readers[MAX_THREADS];
+	struct renamer renamers[MAX_RENAMERS] = {};
+	unsigned long long hits_before[MAX_PROBES] = {},
+			   hits_after[MAX_PROBES] = {};
+	unsigned long long hist[NB_BUCKETS] = {}, opens = 0, enoent = 0,
+			   errors = 0, max_ns = 0, renames = 0, attempts, start,
+			   ns;
+	const struct timespec duration = { .tv_sec = seconds };
+	int err = 0, opening, walking;
+	unsigned int i, b;
+
+	memset(readers, 0, sizeof(*readers) * nb_readers);
+	storm->stop = 0;
+	if (pthread_barrier_init(&storm->barrier, NULL,
+				 nb_readers + nb_renamers + 1))
+		return -1;
+
+	for (i = 0; i < nb_readers; i++) {
+		readers[i].storm = storm;
+		readers[i].index = i;
+		if (pthread_create(&readers[i].tid, NULL, read_worker,
+				   &readers[i])) {
+			fprintf(stderr, "Failed to create thread\n");
+			exit(1);
+		}
+	}
+	for (i = 0; i < nb_renamers; i++) {
+		renamers[i].storm = storm;
+		renamers[i].rng_state = i + 1;
+		if (pthread_create(&renamers[i].tid, NULL, rename_worker,
+				   &renamers[i])) {
+			fprintf(stderr, "Failed to create thread\n");
+			exit(1);
+		}
+	}
+
+	if (nb_probes)
+		read_probes(hits_before);
+	pthread_barrier_wait(&storm->barrier);
+	start = now_ns();
+	nanosleep(&duration, NULL);
+	__atomic_store_n(&storm->stop, 1, __ATOMIC_RELAXED);
+
+	for (i = 0; i < nb_readers; i++)
+		pthread_join(readers[i].tid, NULL);
+	ns = now_ns() - start;
+	for (i = 0; i < nb_renamers; i++)
+		pthread_join(renamers[i].tid, NULL);
+	if (nb_probes)
+		read_probes(hits_after);
+	pthread_barrier_destroy(&storm->barrier);
+
+	for (i = 0; i < nb_readers; i++) {
+		if (readers[i].err) {
+			errno = readers[i].err;
+			err = -1;
+		}
+		for (b = 0; b < NB_BUCKETS; b++)
+			hist[b] += readers[i].hist[b];
+		opens += readers[i].opens;
+		enoent += readers[i].enoent;
+		errors += readers[i].errors;
+		if (readers[i].max_ns > max_ns)
+			max_ns = readers[i].max_ns;
+	}
+	for (i = 0; i < nb_renamers; i++)
+		renames += renamers[i].renames;
+	if (err)
+		return -1;
+
+	attempts = opens + enoent + errors;
+	printf("%-8s %9u %-10s %12.0f %8.3f%% %8llu %9llu %9llu %9llu %9llu %9llu %12.0f\n",
+	       mode, nb_renamers, numa_placement_names[storm->placement],
+	       opens * 1e9 / ns,
+	       attempts ? 100.0 * enoent / attempts : 0, errors,
+	       percentile(hist, opens, 0.5), percentile(hist, opens, 0.9),
+	       percentile(hist, opens, 0.99), percentile(hist, opens, 0.999),
+	       max_ns, renames * 1e9 / ns);
+
+	if (nb_probes && attempts) {
+		printf("[trace] sandbox=%s renamers=%u placement=%s", mode,
+		       nb_renamers, numa_placement_names[storm->placement]);
+		for (i = 0; i < nb_probes; i++)
+			printf(" %s=%.3f/open", probes[i] + 3,
+			       (double)(hits_after[i] - hits_before[i]) /
+				       attempts);
+		opening = find_probe("do_filp_open");
+		walking = find_probe("path_openat");
+		if (opening >= 0 && walking >= 0 &&
+		    hits_after[opening] > hits_before[opening])
+			printf(" retry=%.3f%%",
+			       100.0 *
+				       ((double)(hits_after[walking] -
+						 hits_before[walking]) -
+					(double)(hits_after[opening] -
+						 hits_before[opening])) /
+				       (hits_after[opening] -
+					hits_before[opening]));
+		printf("\n");
+	}
+	fflush(stdout);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int counts[MAX_RENAMERS + 1] = { 0, 1, 2, 4 };
+	unsigned int nb_counts = 4, nb_readers = 4, seconds = 2, i, p;
+	enum numa_placement placements[MAX_PLACEMENTS] = { NUMA_ANY };
+	unsigned int nb_placements = 1;
+	struct storm storm = { .depth = 8, .ruleset_fd = -1 };
+	char *list, *token, *saveptr = NULL, *probe_list = NULL;
+	int opt, ruleset_fd, placement, ret = 1;
+	bool placed = false;
+
+	while ((opt = getopt(argc, argv, "m:k:d:t:p:N:")) != -1) {
+		switch (opt) {
+		case 'm':
+			nb_readers = atoi(optarg);
+			break;
+		case 'k':
+			nb_counts = 0;
+			for (list = optarg; (token = strtok_r(list, ",", &saveptr));
+			     list = NULL) {
+				if (nb_counts > MAX_RENAMERS ||
+				    atoi(token) < 0 || atoi(token) > MAX_RENAMERS)
+					goto usage;
+				counts[nb_counts++] = atoi(token);
+			}
+			break;
+		case 'd':
+			storm.depth = atoi(optarg);
+			break;
+		case 't':
+			seconds = atoi(optarg);
+			break;
+		case 'p':
+			probe_list = optarg;
+			break;
+		case 'N':
+			nb_placements = 0;
+			for (list = optarg; (token = strtok_r(list, ",", &saveptr));
+			     list = NULL) {
+				placement = numa_parse_placement(token);
+				if (nb_placements >= MAX_PLACEMENTS ||
+				    placement < 0)
+					goto usage;
+				placements[nb_placements++] = placement;
+			}
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || nb_readers <= 0 ||
+	    nb_readers > MAX_THREADS || !nb_counts || storm.depth <= 0 ||
+	    storm.depth > MAX_DEPTH || seconds <= 0 || !nb_placements)
+		goto usage;
+
+	if (numa_read_nodes(&nodes)) {
+		perror("Failed to read the NUMA nodes");
+		return 1;
+	}
+	for (p = 0; p < nb_placements; p++) {
+		if (placements[p] == NUMA_CROSS && nodes.nb < 2) {
+			fprintf(stderr,
+				"ERROR: The cross placement requires at least two NUMA nodes\n");
+			return 1;
+		}
+		if (placements[p] != NUMA_ANY)
+			placed = true;
+	}
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+
+	if (create_chain(argv[optind], &storm)) {
+		perror("Failed to create the directory chain");
+		return 1;
+	}
+
+	/* The ruleset is allocated on the node of its creator. */
+	if (placed && numa_pin_home(&nodes)) {
+		perror("Failed to pin to the home node");
+		return 1;
+	}
+	ruleset_fd = create_ruleset();
+	if (ruleset_fd < 0) {
+		perror("Failed to create the ruleset");
+		return 1;
+	}
+	if (placed && numa_unpin(&nodes)) {
+		perror("Failed to unpin");
+		return 1;
+	}
+
+	if (probe_list && setup_probes(probe_list))
+		goto out;
+
+	printf("[*] Opening %s with %u reader(s), %u second(s) per run\n",
+	       storm.path, nb_readers, seconds);
+	printf("%-8s %9s %-10s %12s %9s %8s %9s %9s %9s %9s %9s %12s\n",
+	       "sandbox", "renamers", "placement", "opens/s", "enoent", "errors", "p50(ns)",
+	       "p90(ns)", "p99(ns)", "p99.9(ns)", "max(ns)", "renames/s");
+	for (i = 0; i < nb_counts; i++) {
+		for (p = 0; p < nb_placements; p++) {
+			storm.placement = placements[p];
+			storm.ruleset_fd = -1;
+			if (run(&storm, nb_readers, counts[i], seconds,
+				"none")) {
+				perror("Failed to place a reader");
+				goto out;
+			}
+			storm.ruleset_fd = ruleset_fd;
+			if (run(&storm, nb_readers, counts[i], seconds,
+				"landlock")) {
+				perror("Failed to place or sandbox a reader");
+				goto out;
+			}
+		}
+	}
+	ret = 0;
+
+out:
+	cleanup_probes();
+	close(ruleset_fd);
+	return ret;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-m readers] [-k renamers[,renamers]...] [-d depth] [-t seconds] [-p function[,function]...] [-N placement[,placement]...] <dir>\n",
+		argv[0]);
+	return 1;
+}
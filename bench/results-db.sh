@@ -0,0 +1,363 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Store benchmark results in a local SQLite database, and query them across
+# kernels and dates.
+#
+# Each ingested microbench.sh output is a run, keyed by the "[meta]" lines it
+# starts with: kernel commit, kernel config hash, host, CPU model, number of
+# iterations and profile.  Each run has the open(2) latency measured for each
+# path depth, with and without sandbox, and the calibration measures if any
+# (cf. calibrate.c).
+#
+# cd linux
+# .../microbench.sh vm0 | tee >(.../results-db.sh ingest) | .../filter-microbench.awk
+# .../results-db.sh trend 29
+# .../results-db.sh html trend.html
+#
+# Commands:
+# - ingest [note]: read a microbench.sh output from stdin
+# - runs: list the runs
+# - trend [depth [host]]: print the latencies and sandbox overhead of each run,
+#   optionally for one path depth (0, 9, 19 or 29 with microbench.sh)
+# - calib [host]: print the calibrated Landlock delta of each run, with its
+#   error and in number of null syscalls, to compare hosts
+# - html <file> [host]: render the trends as static HTML with SVG charts
+# - sql <query>: run an arbitrary query
+#
+# Set RESULTS_DB to use another database file.  Requires sqlite3.
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+RESULTS_DB="${RESULTS_DB:-${XDG_DATA_HOME:-${HOME}/.local/share}/landlock-test-tools/results.db}"
+
+usage() {
+	echo "usage: ${BASENAME} ingest [note] | runs | trend [depth [host]] | calib [host] | html <file> [host] | sql <query>" >&2
+	exit 1
+}
+
+if [[ $# -lt 1 ]]; then
+	usage
+fi
+
+if ! command -v sqlite3 >/dev/null; then
+	echo "ERROR: sqlite3 not found" >&2
+	exit 1
+fi
+
+db() {
+	sqlite3 -batch -bail "$@" "${RESULTS_DB}"
+}
+
+# Doubles single quotes for SQL string literals.
+quote() {
+	printf "'%s'" "${1//\'/\'\'}"
+}
+
+init_db() {
+	mkdir -p -- "$(dirname -- "${RESULTS_DB}")"
+	db <<- EOF
+	CREATE TABLE IF NOT EXISTS runs (
+		id INTEGER PRIMARY KEY,
+		date TEXT NOT NULL,
+		kernel TEXT NOT NULL,
+		describe TEXT NOT NULL,
+		config TEXT NOT NULL,
+		host TEXT NOT NULL,
+		cpu TEXT NOT NULL,
+		iterations INTEGER NOT NULL,
+		profile TEXT NOT NULL,
+		note TEXT NOT NULL
+	);
+	CREATE TABLE IF NOT EXISTS results (
+		run_id INTEGER NOT NULL REFERENCES runs(id),
+		bench TEXT NOT NULL,
+		depth INTEGER NOT NULL,
+		sandbox INTEGER NOT NULL,
+		ns REAL NOT NULL,
+		stddev REAL
+	);
+	CREATE INDEX IF NOT EXISTS results_run ON results(run_id);
+	EOF
+}
+
+# Converts a microbench.sh output to SQL statements, in one transaction.
+ingest() {
+	local note="${1:-}"
+
+	awk -v date="$(date -u '+%F %T')" -v note="${note}" -v q="'" '
+	function sql(s) {
+		gsub(q, q q, s)
+		return q s q
+	}
+
+	function flush() {
+		if (ns != "") {
+			results = results sprintf("INSERT INTO results VALUES (last_insert_rowid_run, %s, %d, %d, %s, %s);\n", sql("open"), depth, sandbox, ns, stddev == "" ? "NULL" : stddev)
+		}
+		ns = ""
+		stddev = ""
+	}
+
+	BEGIN {
+		meta["kernel"] = meta["describe"] = meta["config"] = "-"
+		meta["host"] = meta["cpu"] = meta["profile"] = "-"
+		meta["iterations"] = 0
+	}
+
+	$1 == "[meta]" {
+		key = $2
+		sub(/=.*/, "", key)
+		value = $0
+		sub(/^\[meta\] [^=]*=/, "", value)
+		meta[key] = value
+	}
+
+	$1 == "[*]" && $NF ~ /^d=/ {
+		flush()
+		sandbox = ($2 == "with")
+		d = $NF
+		sub(/^d=/, "", d)
+		gsub(/\/+$/, "", d)
+		depth = gsub(/\//, "", d)
+	}
+
+	# Raw perf trace summary (in milliseconds).
+	$1 == "openat" && NF >= 8 {
+		ns = $6 * 1000000
+		stddev = $8
+		sub(/%$/, "", stddev)
+	}
+
+	# filter-microbench.awk output.
+	$1 == "=>" && $2 == "avg:" {
+		ns = $3 * 1000
+	}
+
+	# open-ntimes output, when perf is not available.
+	$1 == "ns/op:" {
+		ns = $2
+	}
+
+	# calibrate output, with the standard error in percent.  The deltas are
+	# computed from the open latencies.
+	$1 == "[calib]" && $2 != "delta" {
+		delete field
+		for (i = 3; i <= NF; i++) {
+			split($i, kv, "=")
+			field[kv[1]] = kv[2]
+		}
+		sub(/%$/, "", field["err"])
+		results = results sprintf("INSERT INTO results VALUES (last_insert_rowid_run, %s, %d, %d, %s, %s);\n", sql("calib-" $2), field["d"], field["sandbox"], field["ns"], field["err"])
+	}
+
+	END {
+		flush()
+		if (results == "") {
+			print "ERROR: No result found" > "/dev/stderr"
+			exit 1
+		}
+		print "BEGIN;"
+		printf("INSERT INTO runs (date, kernel, describe, config, host, cpu, iterations, profile, note) VALUES (%s, %s, %s, %s, %s, %s, %d, %s, %s);\n", sql(date), sql(meta["kernel"]), sql(meta["describe"]), sql(meta["config"]), sql(meta["host"]), sql(meta["cpu"]), meta["iterations"], sql(meta["profile"]), sql(note))
+		gsub(/last_insert_rowid_run/, "(SELECT max(id) FROM runs)", results)
+		printf("%s", results)
+		print "COMMIT;"
+		printf("SELECT %s || max(id) FROM runs;\n", sql("[+] Ingested run "))
+	}' | db
+}
+
+# Prints one line per run and depth, tab-separated: id, date, kernel,
+# describe, host, depth, base ns, sandbox ns, overhead percent.
+trend_rows() {
+	local depth="${1:-}"
+	local host="${2:-}"
+	local where="1"
+
+	if [[ -n "${depth}" ]]; then
+		if [[ ! "${depth}" =~ ^[0-9]+$ ]]; then
+			echo "ERROR: Invalid depth: ${depth}" >&2
+			exit 1
+		fi
+		where="${where} AND r.depth = ${depth}"
+	fi
+	if [[ -n "${host}" ]]; then
+		where="${where} AND u.host = $(quote "${host}")"
+	fi
+
+	db -separator $'\t' <<- EOF
+	SELECT u.id, u.date, substr(u.kernel, 1, 12), u.describe, u.host, r.depth,
+		printf('%.1f', avg(CASE WHEN r.sandbox = 0 THEN r.ns END)),
+		printf('%.1f', avg(CASE WHEN r.sandbox = 1 THEN r.ns END)),
+		printf('%.1f', 100.0 * (avg(CASE WHEN r.sandbox = 1 THEN r.ns END) -
+			avg(CASE WHEN r.sandbox = 0 THEN r.ns END)) /
+			avg(CASE WHEN r.sandbox = 0 THEN r.ns END))
+	FROM results r JOIN runs u ON u.id = r.run_id
+	WHERE ${where} AND r.bench = 'open'
+	GROUP BY u.id, r.depth
+	ORDER BY r.depth, u.date, u.id;
+	EOF
+}
+
+trend() {
+	trend_rows "$@" | awk -F '\t' '
+	BEGIN {
+		printf("%-5s %-19s %-12s %-24s %-12s %5s %10s %10s %9s\n", "run", "date", "kernel", "describe", "host", "depth", "base(ns)", "sandbox(ns)", "overhead")
+	}
+	{
+		printf("%-5s %-19s %-12s %-24s %-12s %5s %10s %10s %8s%%\n", $1, $2, $3, $4, $5, $6, $7, $8, $9)
+	}'
+}
+
+# Prints one line per run and depth, tab-separated: id, date, kernel, host,
+# depth, base ns and error percent, sandbox ns and error percent, null syscall
+# ns.
+calib_rows() {
+	local host="${1:-}"
+	local where="r.bench = 'calib-open'"
+
+	if [[ -n "${host}" ]]; then
+		where="${where} AND u.host = $(quote "${host}")"
+	fi
+
+	db -separator $'\t' <<- EOF
+	SELECT u.id, u.date, substr(u.kernel, 1, 12), u.host, r.depth,
+		max(CASE WHEN r.sandbox = 0 THEN r.ns END),
+		max(CASE WHEN r.sandbox = 0 THEN r.stddev END),
+		max(CASE WHEN r.sandbox = 1 THEN r.ns END),
+		max(CASE WHEN r.sandbox = 1 THEN r.stddev END),
+		(SELECT s.ns FROM results s WHERE s.run_id = u.id AND s.bench = 'calib-syscall')
+	FROM results r JOIN runs u ON u.id = r.run_id
+	WHERE ${where}
+	GROUP BY u.id, r.depth
+	ORDER BY r.depth, u.date, u.id;
+	EOF
+}
+
+# Prints the Landlock delta per run and depth, from the calibration measures.
+calib() {
+	calib_rows "$@" | awk -F '\t' '
+	BEGIN {
+		printf("%-5s %-19s %-12s %-12s %5s %10s %10s %10s %8s %9s\n", "run", "date", "kernel", "host", "depth", "base(ns)", "sandbox(ns)", "delta(ns)", "err(ns)", "syscalls")
+	}
+	$6 != "" && $8 != "" {
+		delta = $8 - $6
+		err = sqrt(($6 * $7 / 100) ^ 2 + ($8 * $9 / 100) ^ 2)
+		printf("%-5s %-19s %-12s %-12s %5s %10.1f %10.1f %10.1f %8.1f %9s\n", $1, $2, $3, $4, $5, $6, $8, delta, err, $10 > 0 ? sprintf("%.2f", delta / $10) : "-")
+	}'
+}
+
+# Renders one SVG line chart per depth, with the base and sandbox latencies
+# of each run in date order.
+html() {
+	local file="$1"
+	local host="${2:-}"
+
+	trend_rows "" "${host}" | awk -F '\t' -v host="${host}" '
+	function esc(s) {
+		gsub(/&/, "\\&amp;", s)
+		gsub(/</, "\\&lt;", s)
+		gsub(/>/, "\\&gt;", s)
+		return s
+	}
+
+	function polyline(depth, col, color,    i, x, y, points) {
+		points = ""
+		for (i = 1; i <= count[depth]; i++) {
+			if (value[depth, i, col] == "") {
+				continue
+			}
+			x = 60 + (count[depth] > 1 ? (i - 1) * 620 / (count[depth] - 1) : 310)
+			y = 220 - (max[depth] ? value[depth, i, col] * 200 / max[depth] : 0)
+			points = points sprintf("%.1f,%.1f ", x, y)
+			printf("<circle cx=\"%.1f\" cy=\"%.1f\" r=\"3\" fill=\"%s\"><title>%s: %s ns</title></circle>\n", x, y, color, label[depth, i], value[depth, i, col])
+		}
+		printf("<polyline fill=\"none\" stroke=\"%s\" stroke-width=\"2\" points=\"%s\"/>\n", color, points)
+	}
+
+	$7 != "" || $8 != "" {
+		depth = $6
+		if (!(depth in count)) {
+			depths[++nb_depths] = depth
+		}
+		i = ++count[depth]
+		label[depth, i] = esc($2 " " $4 " (" $5 ", run " $1 ")")
+		value[depth, i, "base"] = $7
+		value[depth, i, "sandbox"] = $8
+		if ($7 + 0 > max[depth]) max[depth] = $7 + 0
+		if ($8 + 0 > max[depth]) max[depth] = $8 + 0
+	}
+
+	END {
+		print "<!DOCTYPE html>"
+		print "<html><head><meta charset=\"utf-8\"><title>Landlock benchmark trends</title></head>"
+		print "<body style=\"font-family: sans-serif\">"
+		printf("<h1>open(2) latency%s</h1>\n", host == "" ? "" : " on " esc(host))
+		print "<p><span style=\"color: #1f77b4\">without sandbox</span>, <span style=\"color: #d62728\">with sandbox</span></p>"
+		for (n = 1; n <= nb_depths; n++) {
+			depth = depths[n]
+			printf("<h2>Depth %d</h2>\n", depth)
+			print "<svg width=\"700\" height=\"240\" xmlns=\"http://www.w3.org/2000/svg\">"
+			print "<line x1=\"60\" y1=\"220\" x2=\"680\" y2=\"220\" stroke=\"black\"/>"
+			print "<line x1=\"60\" y1=\"20\" x2=\"60\" y2=\"220\" stroke=\"black\"/>"
+			printf("<text x=\"55\" y=\"24\" text-anchor=\"end\" font-size=\"12\">%.0f ns</text>\n", max[depth])
+			print "<text x=\"55\" y=\"220\" text-anchor=\"end\" font-size=\"12\">0</text>"
+			polyline(depth, "base", "#1f77b4")
+			polyline(depth, "sandbox", "#d62728")
+			print "</svg>"
+		}
+		print "</body></html>"
+	}' > "${file}"
+	echo "[+] ${file}"
+}
+
+case "$1" in
+	ingest)
+		if [[ $# -gt 2 ]]; then
+			usage
+		fi
+		init_db
+		ingest "${2:-}"
+		;;
+	runs)
+		if [[ $# -ne 1 ]]; then
+			usage
+		fi
+		init_db
+		db -header -column <<< "SELECT id, date, substr(kernel, 1, 12) AS kernel, describe, substr(config, 1, 12) AS config, host, cpu, iterations, profile, note FROM runs ORDER BY date, id;"
+		;;
+	trend)
+		if [[ $# -gt 3 ]]; then
+			usage
+		fi
+		init_db
+		trend "${@:2}"
+		;;
+	calib)
+		if [[ $# -gt 2 ]]; then
+			usage
+		fi
+		init_db
+		calib "${@:2}"
+		;;
+	html)
+		if [[ $# -lt 2 ]] || [[ $# -gt 3 ]]; then
+			usage
+		fi
+		init_db
+		html "${@:2}"
+		;;
+	sql)
+		if [[ $# -ne 2 ]]; then
+			usage
+		fi
+		init_db
+		db -header -column <<< "$2"
+		;;
+	*)
+		usage
+		;;
+esac
@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Compare the boot and test durations of an UML guest with the host root
+# filesystem (hostfs), and with a root filesystem image (cf. make-rootfs.sh).
+#
+# The boot duration goes up to the launch of the command by guest/init.sh, and
+# the test duration is the one of the command.  Each mode is run ROUNDS times
+# (default: 3), alternately, and the reported durations are the averages.
+#
+# .../make-rootfs.sh rootfs.ext4 .../kselftest/kselftest_install/landlock
+# .../bench/rootfs-time.sh .../linux rootfs.ext4 -- .../guest/kselftest.sh .../kselftest/kselftest_install/landlock
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+
+set -e -u -o pipefail
+
+DIRNAME="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+BASE_DIR="$(dirname -- "${DIRNAME}")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+if [[ $# -lt 4 ]] || [[ "$3" != "--" ]]; then
+	echo "usage: ${BASENAME} <linux-uml-kernel> <rootfs-image> -- <exec-path> [exec-arg]..." >&2
+	exit 1
+fi
+
+KERNEL="$1"
+IMAGE="$2"
+shift 2
+
+ROUNDS="${ROUNDS:-3}"
+
+# Prints "[rootfs] mode= boot= test=" from the timestamped guest output.
+run() {
+	local mode="$1"
+	local image="$2"
+	shift 2
+	local start="${EPOCHREALTIME}"
+
+	ROOTFS="${image}" "${BASE_DIR}/uml-run.sh" "${KERNEL}" "$@" </dev/null 2>&1 \
+		| while IFS= read -r line; do
+			printf '%s %s\n' "${EPOCHREALTIME}" "${line}"
+		done \
+		| awk -v mode="${mode}" -v start="${start}" '
+		$2 == "[*]" && $3 == "Launching" {
+			launch = $1
+		}
+		$2 == "[*]" && $3 == "Returned" {
+			end = $1
+			ret = $NF
+		}
+		END {
+			if (launch == "" || end == "") {
+				printf("ERROR: Incomplete %s run\n", mode) > "/dev/stderr"
+				exit 1
+			}
+			printf("[rootfs] mode=%s boot=%.3f test=%.3f ret=%s\n", mode, launch - start, end - launch, ret)
+		}'
+}
+
+RESULTS="$(
+	for round in $(seq 1 "${ROUNDS}"); do
+		echo "[*] Round ${round}/${ROUNDS}" >&2
+		run hostfs "" "$@" | tee /dev/stderr
+		run image "${IMAGE}" "$@" | tee /dev/stderr
+	done
+)"
+
+awk '
+{
+	for (i = 2; i <= NF; i++) {
+		split($i, kv, "=")
+		field[kv[1]] = kv[2]
+	}
+	mode = field["mode"]
+	n[mode]++
+	boot[mode] += field["boot"]
+	test[mode] += field["test"]
+}
+
+END {
+	printf("%-8s %10s %10s\n", "mode", "boot (s)", "test (s)")
+	for (mode in n) {
+		printf("%-8s %10.3f %10.3f\n", mode, boot[mode] / n[mode], test[mode] / n[mode])
+	}
+	if (n["hostfs"] && n["image"]) {
+		printf("[*] Image vs hostfs: boot %+.3f s, test %+.3f s\n", boot["image"] / n["image"] - boot["hostfs"] / n["hostfs"], test["image"] / n["image"] - test["hostfs"] / n["hostfs"])
+	}
+}' <<< "${RESULTS}"
@@ -6,6 +6,9 @@
 # This setup is required to run the benchmarks in a namespace where the root is
 # a tmpfs.  This avoids inconsistent results.
 #
+# Set GEN_TREE to gen-tree options (e.g. "-f 10 -d 5 -n 10") to also generate
+# /tree in the tmpfs, with the list of its paths in /tree.list.
+#
 # Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
 
 set -u -e -o pipefail
@@ -30,15 +33,25 @@ mkdir_mount /bin
 mkdir_mount /sys
 mkdir_mount /proc
 
-cp perf /mnt/
-cp sandboxer /mnt/
-cp open-ntimes /mnt/
+# Copies the available tools, which may not all be built or available on the
+# target (e.g. perf on UML).
+for f in perf sandboxer open-ntimes calibrate truncate-ntimes cost-sweep latency-fuzz gen-tree walk-tree rename-storm shared-open ftrace-landlock.sh perf-fold.sh; do
+	if [[ -e "$f" ]]; then
+		cp "$f" /mnt/
+	fi
+done
 
 mkdir /mnt/old
+# Working directory for the benchmarks (e.g. cost-sweep /tmp).
+mkdir -m 1777 /mnt/tmp
 mkdir -p /mnt/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9
 
 cd /mnt
 pivot_root . old
 cd .
 
+if [[ -n "${GEN_TREE:-}" ]]; then
+	./gen-tree ${GEN_TREE} -j "$(nproc)" /tree > /tree.list
+fi
+
 "$@"
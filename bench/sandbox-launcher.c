@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * sandbox-launcher [-n count] [-j jobs] [-r | -b] -- <command> [args...]
+ *
+ * Launch a command count times (default: 1), with at most jobs children
+ * running at the same time (default: 1), each sandboxed according to LL_FS_RO
+ * and LL_FS_RW (as for the sandboxer).
+ *
+ * The ruleset is built once by the launcher, and each child only enforces it
+ * with landlock_restrict_self(2) before executing the command.  With -r, each
+ * child rebuilds the ruleset instead, as the sandboxer does for each launch.
+ * With -b, both modes are measured one after the other.
+ *
+ * The spawn rate is printed to stderr as "[spawn]" lines when launching more
+ * than one child.
+ *
+ * LL_FS_RO=/usr:/bin:/lib:/lib64 LL_FS_RW=/tmp ./sandbox-launcher -b -n 10000 -- /bin/true
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Sandboxes the child with the prebuilt ruleset, or a fresh one if < 0. */
+static void spawn_child(const int ruleset_fd, char *const argv[])
+{
+	const int err = ruleset_fd < 0 ? ll_sandbox_from_env() :
+					 ll_restrict(ruleset_fd);
+
+	if (err) {
+		perror("Failed to sandbox");
+		_exit(1);
+	}
+	execvp(argv[0], argv);
+	fprintf(stderr, "Failed to execute \"%s\": %s\n", argv[0],
+		strerror(errno));
+	_exit(1);
+}
+
+/* Returns the number of children which failed, or -1 on error. */
+static int launch(const int ruleset_fd, const int count, const int jobs,
+		  char *const argv[])
+{
+	int started = 0, running = 0, failed = 0, status;
+	pid_t child;
+
+	while (started < count || running) {
+		if (started < count && running < jobs) {
+			child = fork();
+			if (child < 0)
+				return -1;
+			if (!child)
+				spawn_child(ruleset_fd, argv);
+			started++;
+			running++;
+			continue;
+		}
+
+		child = wait(&status);
+		if (child < 0)
+			return -1;
+		running--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			failed++;
+	}
+	return failed;
+}
+
+static int run(const bool rebuild, const int count, const int jobs,
+	       char *const argv[])
+{
+	unsigned long long start, elapsed;
+	int ruleset_fd = -1, failed;
+
+	start = now_ns();
+	if (!rebuild) {
+		/* The ruleset FD is O_CLOEXEC, so not inherited by commands. */
+		ruleset_fd = ll_create_ruleset_from_env();
+		if (ruleset_fd < 0) {
+			perror("Failed to create the ruleset");
+			return -1;
+		}
+	}
+	failed = launch(ruleset_fd, count, jobs, argv);
+	elapsed = now_ns() - start;
+	if (ruleset_fd >= 0)
+		close(ruleset_fd);
+
+	if (failed < 0) {
+		perror("Failed to launch");
+		return -1;
+	}
+	if (count > 1)
+		fprintf(stderr,
+			"[spawn] mode=%s children=%d jobs=%d failed=%d seconds=%.3f rate=%.0f\n",
+			rebuild ? "rebuild" : "reuse", count, jobs, failed,
+			elapsed / 1e9, count * 1e9 / elapsed);
+	return failed;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, count = 1, jobs = 1, failed;
+	bool rebuild = false, compare = false;
+
+	while ((opt = getopt(argc, argv, "+n:j:rb")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'j':
+			jobs = atoi(optarg);
+			break;
+		case 'r':
+			rebuild = true;
+			break;
+		case 'b':
+			compare = true;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind >= argc || count <= 0 || jobs <= 0 || (rebuild && compare))
+		goto usage;
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+
+	if (compare) {
+		failed = run(true, count, jobs, argv + optind);
+		if (failed >= 0)
+			failed = run(false, count, jobs, argv + optind);
+	} else {
+		failed = run(rebuild, count, jobs, argv + optind);
+	}
+	return failed ? 1 : 0;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-n count] [-j jobs] [-r | -b] -- <command> [args...]\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * shared-open [-p procs[,procs]...] [-n ntimes] [-r rounds]
+ *             [-N placement[,placement]...] <path>...
+ *
+ * Fork processes which all open the same set of paths (e.g. shared libraries
+ * and configuration files), and print the aggregate throughput for each number
+ * of processes (default: powers of two up to the number of CPUs).  Each
+ * process is pinned to its own CPU, opens the paths ntimes in a round-robin
+ * fashion (default: 100000), and the processes start at the same time.
+ *
+ * Three domain setups are compared:
+ * - none: no sandbox;
+ * - shared: all the processes are in the same Landlock domain;
+ * - separate: each process creates its own domain from the policy template,
+ *   as separately sandboxed services do.
+ *
+ * The policy template is given by LL_FS_RO and LL_FS_RW (as for the
+ * sandboxer), and defaults to LL_FS_RO="/".  A scaling below the one without
+ * sandbox points to cache line bouncing on state shared by the processes
+ * (e.g. the domain or the inode and superblock security blobs).
+ *
+ * With -N, the processes are placed on the NUMA nodes according to each
+ * placement (cf. numa-helpers.h), and the shared domain is created on the
+ * home node.  The throughput and the mean open latency can then be compared
+ * between the local, interleave and cross placements.
+ *
+ * LL_FS_RO=/usr:/etc ./shared-open -p 1,2,4,8 /etc/passwd /usr/lib/x86_64-linux-gnu/libc.so.6
+ * ./shared-open -p 4 -N local,interleave,cross /etc/passwd
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+#include "numa-helpers.h"
+
+#define MAX_COUNTS 32
+#define MAX_PROCS 1024
+#define MAX_PLACEMENTS 8
+
+enum domain {
+	DOMAIN_NONE,
+	DOMAIN_SHARED,
+	DOMAIN_SEPARATE,
+	NB_DOMAINS,
+};
+
+static const char *const domain_names[NB_DOMAINS] = {
+	[DOMAIN_NONE] = "none",
+	[DOMAIN_SHARED] = "shared",
+	[DOMAIN_SEPARATE] = "separate",
+};
+
+struct result {
+	double rate;
+	double ns_per_open;
+};
+
+static struct numa_nodes nodes;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_double(const void *const a, const void *const b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Waits for the start signal (i.e. the end of the start pipe), opens the paths
+ * ntimes, and writes the elapsed time to the result pipe.
+ */
+static void worker(const unsigned int index, const enum domain domain,
+		   const enum numa_placement placement, const int ready_fd,
+		   const int start_fd, const int result_fd, char *const paths[], const unsigned int nb_paths,
+		   const unsigned int ntimes)
+{
+	unsigned long long start, ns;
+	unsigned int i;
+	char c;
+	int fd;
+
+	/*
+	 * The ready pipe is closed as soon as this worker is ready or failed, so
+	 * that the leader gets EOF instead of waiting for a failed worker while
+	 * the others are blocked on the start pipe.
+	 */
+	if (numa_pin_worker(&nodes, placement, index)) {
+		perror("Failed to pin to a CPU");
+		close(ready_fd);
+		_exit(1);
+	}
+	if (domain == DOMAIN_SEPARATE && ll_sandbox_from_env()) {
+		perror("Failed to sandbox");
+		close(ready_fd);
+		_exit(1);
+	}
+	if (write(ready_fd, "", 1) != 1) {
+		close(ready_fd);
+		_exit(1);
+	}
+	close(ready_fd);
+	if (read(start_fd, &c, 1) != 0)
+		_exit(1);
+
+	start = now_ns();
+	for (i = 0; i < ntimes; i++) {
+		fd = open(paths[i % nb_paths], O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			fprintf(stderr, "Failed to open \"%s\": %s\n",
+				paths[i % nb_paths], strerror(errno));
+			_exit(1);
+		}
+		close(fd);
+	}
+	ns = now_ns() - start;
+
+	if (write(result_fd, &ns, sizeof(ns)) != sizeof(ns))
+		_exit(1);
+	_exit(0);
+}
+
+/*
+ * Forks the workers from a leader process, which is sandboxed for the shared
+ * domain, and writes the aggregate number of opens per second and the mean
+ * open latency to out_fd.
+ */
+static void leader(const unsigned int procs, const enum domain domain,
+		   const enum numa_placement placement, const int out_fd, char *const paths[],
+		   const unsigned int nb_paths, const unsigned int ntimes)
+{
+	int ready_pipe[2], start_pipe[2], result_pipe[2], status;
+	unsigned long long ns, max_ns = 0, sum_ns = 0;
+	unsigned int i, received = 0;
+	struct result result;
+	bool failed = false;
+	pid_t child;
+	char c;
+
+	/* The shared domain is allocated on the node of its creator. */
+	if (placement != NUMA_ANY && numa_pin_home(&nodes)) {
+		perror("Failed to pin to the home node");
+		_exit(1);
+	}
+	if (domain == DOMAIN_SHARED && ll_sandbox_from_env()) {
+		perror("Failed to sandbox");
+		_exit(1);
+	}
+
+	if (pipe2(ready_pipe, O_CLOEXEC) || pipe2(start_pipe, O_CLOEXEC) ||
+	    pipe2(result_pipe, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		_exit(1);
+	}
+
+	for (i = 0; i < procs; i++) {
+		child = fork();
+		if (child < 0) {
+			perror("Failed to fork");
+			_exit(1);
+		}
+		if (!child) {
+			close(ready_pipe[0]);
+			close(start_pipe[1]);
+			close(result_pipe[0]);
+			worker(i, domain, placement, ready_pipe[1],
+			       start_pipe[0], result_pipe[1], paths, nb_paths,
+			       ntimes);
+		}
+	}
+	close(ready_pipe[1]);
+	close(start_pipe[0]);
+	close(result_pipe[1]);
+
+	/* Starts all the workers once they are pinned and sandboxed. */
+	for (i = 0; i < procs; i++) {
+		if (read(ready_pipe[0], &c, 1) != 1)
+			break;
+	}
+	close(start_pipe[1]);
+
+	while (read(result_pipe[0], &ns, sizeof(ns)) == sizeof(ns)) {
+		received++;
+		sum_ns += ns;
+		if (ns > max_ns)
+			max_ns = ns;
+	}
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			failed = true;
+	}
+	if (failed || received != procs || !max_ns)
+		_exit(1);
+
+	result.rate = (double)procs * ntimes * 1e9 / max_ns;
+	result.ns_per_open = (double)sum_ns / procs / ntimes;
+	if (write(out_fd, &result, sizeof(result)) != sizeof(result))
+		_exit(1);
+	_exit(0);
+}
+
+static int run(const unsigned int procs, const enum domain domain,
+	       const enum numa_placement placement, char *const paths[],
+	       const unsigned int nb_paths, const unsigned int ntimes,
+	       struct result *const result)
+{
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		return -1;
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return -1;
+	}
+	if (!child) {
+		close(pipefd[0]);
+		leader(procs, domain, placement, pipefd[1], paths, nb_paths,
+		       ntimes);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], result, sizeof(*result)) == sizeof(*result);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int counts[MAX_COUNTS], nb_counts = 0, ntimes = 100000,
+					 rounds = 3, nb_cpus, i, r;
+	enum numa_placement placements[MAX_PLACEMENTS] = { NUMA_ANY };
+	unsigned int nb_placements = 1, p;
+	char *list, *token, *saveptr = NULL;
+	enum domain d;
+	int opt, placement;
+
+	while ((opt = getopt(argc, argv, "p:n:r:N:")) != -1) {
+		switch (opt) {
+		case 'p':
+			for (list = optarg; (token = strtok_r(list, ",", &saveptr));
+			     list = NULL) {
+				if (nb_counts >= MAX_COUNTS || atoi(token) <= 0 ||
+				    atoi(token) > MAX_PROCS)
+					goto usage;
+				counts[nb_counts++] = atoi(token);
+			}
+			break;
+		case 'n':
+			ntimes = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		case 'N':
+			nb_placements = 0;
+			for (list = optarg; (token = strtok_r(list, ",", &saveptr));
+			     list = NULL) {
+				placement = numa_parse_placement(token);
+				if (nb_placements >= MAX_PLACEMENTS ||
+				    placement < 0)
+					goto usage;
+				placements[nb_placements++] = placement;
+			}
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind >= argc || ntimes <= 0 || rounds <= 0 || !nb_placements)
+		goto usage;
+
+	if (numa_read_nodes(&nodes)) {
+		perror("Failed to read the NUMA nodes");
+		return 1;
+	}
+	for (p = 0; p < nb_placements; p++) {
+		if (placements[p] == NUMA_CROSS && nodes.nb < 2) {
+			fprintf(stderr,
+				"ERROR: The cross placement requires at least two NUMA nodes\n");
+			return 1;
+		}
+	}
+	nb_cpus = CPU_COUNT(&nodes.allowed);
+	if (!nb_counts) {
+		for (i = 1; i < nb_cpus && nb_counts < MAX_COUNTS - 1; i *= 2)
+			counts[nb_counts++] = i;
+		counts[nb_counts++] = nb_cpus;
+	}
+
+	if (ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+	if (!getenv("LL_FS_RO") && !getenv("LL_FS_RW"))
+		setenv("LL_FS_RO", "/", 1);
+
+	printf("[*] Opening %d path(s) %u times per process on %u CPU(s) and %d NUMA node(s), %u round(s)\n",
+	       argc - optind, ntimes, nb_cpus, nodes.nb, rounds);
+	printf("%-10s %-10s %6s %14s %14s %9s %9s %9s\n", "domain",
+	       "placement", "procs", "opens/s", "opens/s/proc", "ns/open",
+	       "scaling", "overhead");
+	for (p = 0; p < nb_placements; p++) {
+		double single[NB_DOMAINS] = {}, base = 0;
+
+		for (i = 0; i < nb_counts; i++) {
+			for (d = 0; d < NB_DOMAINS; d++) {
+				double rates[rounds], latencies[rounds], rate,
+					latency;
+				struct result result;
+
+				for (r = 0; r < rounds; r++) {
+					if (run(counts[i], d, placements[p],
+						argv + optind, argc - optind,
+						ntimes, &result)) {
+						fprintf(stderr,
+							"Failed to run %u %s process(es)\n",
+							counts[i],
+							domain_names[d]);
+						return 1;
+					}
+					rates[r] = result.rate;
+					latencies[r] = result.ns_per_open;
+				}
+				qsort(rates, rounds, sizeof(*rates), cmp_double);
+				qsort(latencies, rounds, sizeof(*latencies),
+				      cmp_double);
+				rate = rates[rounds / 2];
+				latency = latencies[rounds / 2];
+
+				/* The scaling is relative to the first count. */
+				if (i == 0)
+					single[d] = rate / counts[i];
+				if (d == DOMAIN_NONE)
+					base = rate;
+				printf("%-10s %-10s %6u %14.0f %14.0f %9.1f %8.1f%% %8.1f%%\n",
+				       domain_names[d],
+				       numa_placement_names[placements[p]],
+				       counts[i], rate, rate / counts[i],
+				       latency,
+				       100 * rate / (single[d] * counts[i]),
+				       100 * (base - rate) / rate);
+			}
+		}
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-p procs[,procs]...] [-n ntimes] [-r rounds] [-N placement[,placement]...] <path>...\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * truncate-ntimes <ntimes> <dir>...
+ *
+ * For each directory, create a file and measure the latency of
+ * open(O_WRONLY|O_TRUNC), truncate(path) and ftruncate(fd) on it, without
+ * sandbox, with a Landlock domain not handling LANDLOCK_ACCESS_FS_TRUNCATE, and
+ * with a domain handling it.  Both domains allow everything beneath /.
+ *
+ * The truncate right of a file descriptor is computed when it is opened, so
+ * ftruncate(fd) should not get slower with a domain handling it.
+ *
+ * IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./truncate-ntimes 1000000 / /1/2/3/4/5/6/7/8/9/
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+enum op {
+	OP_OPEN_TRUNC,
+	OP_TRUNCATE,
+	OP_FTRUNCATE,
+	OP_MAX,
+};
+
+static const char *const op_names[] = {
+	[OP_OPEN_TRUNC] = "open(O_TRUNC)",
+	[OP_TRUNCATE] = "truncate",
+	[OP_FTRUNCATE] = "ftruncate",
+};
+
+enum sandbox {
+	SANDBOX_NONE,
+	SANDBOX_NO_TRUNCATE,
+	SANDBOX_TRUNCATE,
+	SANDBOX_MAX,
+};
+
+static const char *const sandbox_names[] = {
+	[SANDBOX_NONE] = "none",
+	[SANDBOX_NO_TRUNCATE] = "landlock",
+	[SANDBOX_TRUNCATE] = "landlock+truncate",
+};
+
+static int sandbox(const enum sandbox mode)
+{
+	const __u64 access = (LL_ACCESS_FS_ROUGHLY_READ |
+			      LL_ACCESS_FS_ROUGHLY_WRITE) &
+			     ~(mode == SANDBOX_TRUNCATE ?
+				       0 :
+				       LANDLOCK_ACCESS_FS_TRUNCATE);
+	int ruleset_fd, err;
+
+	if (mode == SANDBOX_NONE)
+		return 0;
+
+	ruleset_fd = ll_create_ruleset(access);
+	if (ruleset_fd < 0)
+		return -1;
+
+	err = ll_add_path(ruleset_fd, "/", access);
+	if (!err)
+		err = ll_restrict(ruleset_fd);
+	close(ruleset_fd);
+	return err;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Returns the average latency in nanoseconds, or a negative value on error. */
+static double measure(const enum op op, const char *const path,
+		      const size_t ntimes)
+{
+	unsigned long long start;
+	size_t i;
+	int fd = -1;
+
+	if (op == OP_FTRUNCATE) {
+		/* The truncate right is checked once, here. */
+		fd = open(path, O_WRONLY | O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+	}
+
+	start = now_ns();
+	for (i = 0; i < ntimes; i++) {
+		switch (op) {
+		case OP_OPEN_TRUNC:
+			fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+			if (fd < 0)
+				return -1;
+			close(fd);
+			break;
+		case OP_TRUNCATE:
+			if (truncate(path, 0))
+				return -1;
+			break;
+		case OP_FTRUNCATE:
+			if (ftruncate(fd, 0))
+				return -1;
+			break;
+		default:
+			return -1;
+		}
+	}
+	if (op == OP_FTRUNCATE)
+		close(fd);
+	return (double)(now_ns() - start) / ntimes;
+}
+
+/* Measures all the operations in a child process, which may be sandboxed. */
+static int run(const enum sandbox mode, const char *const path,
+	       const size_t ntimes, double results[OP_MAX])
+{
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		return -1;
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return -1;
+	}
+	if (!child) {
+		enum op op;
+
+		close(pipefd[0]);
+		if (sandbox(mode)) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		for (op = 0; op < OP_MAX; op++) {
+			results[op] = measure(op, path, ntimes);
+			if (results[op] < 0) {
+				fprintf(stderr, "Failed to %s %s: %s\n",
+					op_names[op], path, strerror(errno));
+				_exit(1);
+			}
+		}
+		if (write(pipefd[1], results, sizeof(*results) * OP_MAX) !=
+		    sizeof(*results) * OP_MAX)
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], results, sizeof(*results) * OP_MAX) ==
+		   sizeof(*results) * OP_MAX;
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	double results[SANDBOX_MAX][OP_MAX];
+	ssize_t ntimes;
+	char path[PATH_MAX];
+	enum sandbox mode;
+	enum op op;
+	int i, fd;
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s <ntimes> <dir>...\n", argv[0]);
+		return 1;
+	}
+
+	ntimes = atoi(argv[1]);
+	printf("ntimes: %ld\n", ntimes);
+	if (ntimes <= 0)
+		return 1;
+
+	if (ll_get_abi() < 3) {
+		fprintf(stderr,
+			"Landlock ABI 3 is required to handle truncation\n");
+		return 1;
+	}
+
+	for (i = 2; i < argc; i++) {
+		if (snprintf(path, sizeof(path), "%s/truncate-ntimes",
+			     argv[i]) >= sizeof(path))
+			return 1;
+
+		fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "Failed to create %s: %s\n", path,
+				strerror(errno));
+			return 1;
+		}
+		close(fd);
+
+		printf("path: %s\n", path);
+		for (mode = 0; mode < SANDBOX_MAX; mode++) {
+			if (run(mode, path, ntimes, results[mode]))
+				return 1;
+		}
+
+		printf("%-14s", "ns/op");
+		for (mode = 0; mode < SANDBOX_MAX; mode++)
+			printf(" %*s", mode == SANDBOX_TRUNCATE ? 18 : 14,
+			       sandbox_names[mode]);
+		printf("\n");
+		for (op = 0; op < OP_MAX; op++) {
+			printf("%-14s", op_names[op]);
+			for (mode = 0; mode < SANDBOX_MAX; mode++)
+				printf(" %*.1f", mode == SANDBOX_TRUNCATE ? 18 : 14,
+				       results[mode][op]);
+			printf("\n");
+		}
+
+		/* Only the check at open time should depend on the path. */
+		printf("ftruncate overhead with truncate handled: %+.1f ns (%+.1f%%)\n",
+		       results[SANDBOX_TRUNCATE][OP_FTRUNCATE] -
+			       results[SANDBOX_NONE][OP_FTRUNCATE],
+		       100 * (results[SANDBOX_TRUNCATE][OP_FTRUNCATE] -
+			      results[SANDBOX_NONE][OP_FTRUNCATE]) /
+			       results[SANDBOX_NONE][OP_FTRUNCATE]);
+		unlink(path);
+	}
+	return 0;
+}
@@ -0,0 +1,459 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * walk-tree [-j threads] [-r rounds] [-l level[,level]...] <root>
+ *
+ * Recursively walk a directory tree (e.g. generated with gen-tree) with
+ * getdents64, fstatat and openat(O_DIRECTORY), like find does, and print the
+ * number of entries per second without sandbox and with a Landlock domain
+ * handling read access rights.  Each level selects the rules of a sandboxed
+ * walk:
+ * - -1: one rule on /, outside the tree;
+ * - 0: one rule on the tree root;
+ * - N: one rule on the tree root and one on each directory at depth N, which
+ *   shortens Landlock's parent walks below this depth.
+ *
+ * With several threads, the directories are distributed among per-thread
+ * queues, and idle threads steal work from the others.
+ *
+ * GEN_TREE="-f 10 -d 5 -n 10" IN_BENCHMARK_NS=1 unshare --mount -- ./run-bench-in-namespace.sh ./walk-tree -j 4 -l -1,0,3 /tree
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+
+#define MAX_LEVELS 16
+#define NO_SANDBOX INT_MIN
+
+struct linux_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/* Queue of directory file descriptors, owned by one thread. */
+struct queue {
+	pthread_mutex_t lock;
+	int *fds;
+	size_t head;
+	size_t tail;
+	size_t capacity;
+};
+
+struct walk {
+	struct queue *queues;
+	unsigned int nb_queues;
+	/* Directories queued or being read. */
+	unsigned long pending;
+};
+
+struct walk_stats {
+	unsigned long long entries;
+	unsigned long long errors;
+	unsigned long long ns;
+};
+
+struct worker {
+	struct walk *walk;
+	unsigned int id;
+	struct walk_stats stats;
+};
+
+static int queue_push(struct queue *const queue, const int fd)
+{
+	int err = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->head == queue->tail) {
+		queue->head = 0;
+		queue->tail = 0;
+	}
+	if (queue->tail == queue->capacity) {
+		const size_t len = queue->tail - queue->head;
+		const size_t capacity = queue->capacity ? queue->capacity * 2 :
+							  1024;
+		int *const fds = malloc(capacity * sizeof(*fds));
+
+		if (fds) {
+			memcpy(fds, queue->fds + queue->head,
+			       len * sizeof(*fds));
+			free(queue->fds);
+			queue->fds = fds;
+			queue->capacity = capacity;
+			queue->head = 0;
+			queue->tail = len;
+		} else {
+			err = -1;
+		}
+	}
+	if (!err)
+		queue->fds[queue->tail++] = fd;
+	pthread_mutex_unlock(&queue->lock);
+	return err;
+}
+
+/* The owner takes the last pushed directory, for locality. */
+static int queue_pop(struct queue *const queue)
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->tail > queue->head)
+		fd = queue->fds[--queue->tail];
+	pthread_mutex_unlock(&queue->lock);
+	return fd;
+}
+
+/* Thieves take the oldest directory, which is likely the biggest subtree. */
+static int queue_steal(struct queue *const queue)
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->tail > queue->head)
+		fd = queue->fds[queue->head++];
+	pthread_mutex_unlock(&queue->lock);
+	return fd;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void read_dir(struct worker *const worker, const int dirfd)
+{
+	struct queue *const queue = &worker->walk->queues[worker->id];
+	char buf[32768];
+	struct stat st;
+	long len, pos;
+
+	while ((len = syscall(SYS_getdents64, dirfd, buf, sizeof(buf))) > 0) {
+		for (pos = 0; pos < len;) {
+			const struct linux_dirent64 *const d = (void *)(buf + pos);
+			const char *const name = d->d_name;
+			int fd;
+
+			pos += d->d_reclen;
+			if (name[0] == '.' &&
+			    (!name[1] || (name[1] == '.' && !name[2])))
+				continue;
+
+			worker->stats.entries++;
+			if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW)) {
+				worker->stats.errors++;
+				continue;
+			}
+			if (!S_ISDIR(st.st_mode))
+				continue;
+
+			/* Checked by Landlock for LANDLOCK_ACCESS_FS_READ_DIR. */
+			fd = openat(dirfd, name,
+				    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd < 0) {
+				worker->stats.errors++;
+				continue;
+			}
+			__atomic_add_fetch(&worker->walk->pending, 1,
+					   __ATOMIC_RELAXED);
+			if (queue_push(queue, fd)) {
+				close(fd);
+				worker->stats.errors++;
+				__atomic_sub_fetch(&worker->walk->pending, 1,
+						   __ATOMIC_RELEASE);
+			}
+		}
+	}
+	if (len < 0)
+		worker->stats.errors++;
+}
+
+static void *walk_worker(void *const arg)
+{
+	struct worker *const worker = arg;
+	struct walk *const walk = worker->walk;
+	unsigned int i;
+	int fd;
+
+	while (__atomic_load_n(&walk->pending, __ATOMIC_ACQUIRE)) {
+		fd = queue_pop(&walk->queues[worker->id]);
+		for (i = 1; fd < 0 && i < walk->nb_queues; i++)
+			fd = queue_steal(&walk->queues[(worker->id + i) %
+						       walk->nb_queues]);
+		if (fd < 0) {
+			sched_yield();
+			continue;
+		}
+		read_dir(worker, fd);
+		close(fd);
+		__atomic_sub_fetch(&walk->pending, 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+static int walk_tree(const char *const root, const unsigned int threads,
+		     struct walk_stats *const stats)
+{
+	struct walk walk = {
+		.nb_queues = threads,
+		.pending = 1,
+	};
+	struct worker *workers;
+	pthread_t *tids;
+	unsigned long long start;
+	unsigned int i;
+	int fd;
+
+	walk.queues = calloc(threads, sizeof(*walk.queues));
+	workers = calloc(threads, sizeof(*workers));
+	tids = calloc(threads, sizeof(*tids));
+	if (!walk.queues || !workers || !tids)
+		return -1;
+	for (i = 0; i < threads; i++) {
+		pthread_mutex_init(&walk.queues[i].lock, NULL);
+		workers[i].walk = &walk;
+		workers[i].id = i;
+	}
+
+	start = now_ns();
+	fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", root,
+			strerror(errno));
+		return -1;
+	}
+	if (queue_push(&walk.queues[0], fd))
+		return -1;
+
+	for (i = 1; i < threads; i++) {
+		if (pthread_create(&tids[i], NULL, walk_worker, &workers[i])) {
+			fprintf(stderr, "Failed to create thread\n");
+			return -1;
+		}
+	}
+	walk_worker(&workers[0]);
+	for (i = 1; i < threads; i++)
+		pthread_join(tids[i], NULL);
+
+	memset(stats, 0, sizeof(*stats));
+	stats->ns = now_ns() - start;
+	for (i = 0; i < threads; i++) {
+		stats->entries += workers[i].stats.entries;
+		stats->errors += workers[i].stats.errors;
+	}
+	return 0;
+}
+
+/* Adds a rule on each directory at a given depth below a directory. */
+static int add_level_rules(const int ruleset_fd, const char *const dir,
+			   const int depth, unsigned long long *const nb_rules)
+{
+	DIR *const d = opendir(dir);
+	struct dirent *entry;
+	char path[PATH_MAX];
+	int err = 0;
+
+	if (!d)
+		return -1;
+
+	while (!err && (entry = readdir(d))) {
+		if (entry->d_type != DT_DIR || !strcmp(entry->d_name, ".") ||
+		    !strcmp(entry->d_name, ".."))
+			continue;
+		if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >=
+		    sizeof(path)) {
+			err = -1;
+			break;
+		}
+		if (depth > 1) {
+			err = add_level_rules(ruleset_fd, path, depth - 1,
+					      nb_rules);
+			continue;
+		}
+		err = ll_add_path(ruleset_fd, path, LL_ACCESS_FS_ROUGHLY_READ);
+		if (!err)
+			(*nb_rules)++;
+	}
+	closedir(d);
+	return err;
+}
+
+static int sandbox(const char *const root, const int level,
+		   unsigned long long *const nb_rules)
+{
+	const int ruleset_fd = ll_create_ruleset(LL_ACCESS_FS_ROUGHLY_READ);
+	int err;
+
+	if (ruleset_fd < 0)
+		return -1;
+
+	*nb_rules = 1;
+	err = ll_add_path(ruleset_fd, level < 0 ? "/" : root,
+			  LL_ACCESS_FS_ROUGHLY_READ);
+	if (!err && level > 0)
+		err = add_level_rules(ruleset_fd, root, level, nb_rules);
+	if (!err)
+		err = ll_restrict(ruleset_fd);
+	close(ruleset_fd);
+	return err;
+}
+
+/* Walks the tree in a child process, which may be sandboxed. */
+static int run(const char *const root, const unsigned int threads,
+	       const int level, struct walk_stats *const stats,
+	       unsigned long long *const nb_rules)
+{
+	struct {
+		struct walk_stats stats;
+		unsigned long long nb_rules;
+	} result = {};
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (pipe2(pipefd, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		return -1;
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return -1;
+	}
+	if (!child) {
+		close(pipefd[0]);
+		if (level != NO_SANDBOX &&
+		    sandbox(root, level, &result.nb_rules)) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		if (walk_tree(root, threads, &result.stats))
+			_exit(1);
+		if (write(pipefd[1], &result, sizeof(result)) != sizeof(result))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], &result, sizeof(result)) == sizeof(result);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+
+	*stats = result.stats;
+	*nb_rules = result.nb_rules;
+	return 0;
+}
+
+static int cmp_double(const void *const a, const void *const b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+	int levels[MAX_LEVELS + 1] = { NO_SANDBOX, -1, 0 };
+	unsigned int threads = 1, rounds = 5, nb_levels = 3, i, r;
+	const char *root;
+	char *list, *token, *saveptr = NULL;
+	double base = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:r:l:")) != -1) {
+		switch (opt) {
+		case 'j':
+			threads = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		case 'l':
+			nb_levels = 1;
+			for (list = optarg; (token = strtok_r(list, ",", &saveptr));
+			     list = NULL) {
+				if (nb_levels > MAX_LEVELS)
+					goto usage;
+				levels[nb_levels++] = atoi(token);
+			}
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || threads <= 0 || threads > 1024 ||
+	    rounds <= 0)
+		goto usage;
+	root = argv[optind];
+
+	if (nb_levels > 1 && ll_get_abi() < 0) {
+		perror("Landlock is not available");
+		return 1;
+	}
+
+	printf("[*] Walking %s with %u thread(s), %u round(s)\n", root,
+	       threads, rounds);
+	printf("%-12s %8s %12s %8s %14s %10s\n", "sandbox", "rules", "entries",
+	       "errors", "entries/s", "overhead");
+	for (i = 0; i < nb_levels; i++) {
+		struct walk_stats stats = {};
+		unsigned long long nb_rules = 0;
+		double rates[rounds], rate;
+		char name[32];
+
+		for (r = 0; r < rounds; r++) {
+			if (run(root, threads, levels[i], &stats, &nb_rules)) {
+				fprintf(stderr, "Failed to walk %s\n", root);
+				return 1;
+			}
+			rates[r] = stats.entries * 1e9 / stats.ns;
+		}
+		qsort(rates, rounds, sizeof(*rates), cmp_double);
+		rate = rates[rounds / 2];
+
+		if (levels[i] == NO_SANDBOX) {
+			base = rate;
+			snprintf(name, sizeof(name), "none");
+		} else if (levels[i] < 0) {
+			snprintf(name, sizeof(name), "/");
+		} else {
+			snprintf(name, sizeof(name), "level=%d", levels[i]);
+		}
+		printf("%-12s %8llu %12llu %8llu %14.0f %9.1f%%\n", name,
+		       nb_rules, stats.entries, stats.errors, rate,
+		       base ? 100 * (base - rate) / rate : 0);
+	}
+	return 0;
+
+usage:
+	fprintf(stderr,
+		"usage: %s [-j threads] [-r rounds] [-l level[,level]...] <root>\n",
+		argv[0]);
+	return 1;
+}
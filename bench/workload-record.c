@@ -0,0 +1,607 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * workload-record <trace-file> <command> [arg]...
+ *
+ * Record the path-based filesystem syscalls (the ones checked by Landlock at
+ * path resolution) and the TCP bind/connect calls of a command and all its
+ * children, with ptrace, into a compact trace for workload-replay.
+ *
+ * Paths are recorded as absolute paths, resolved against the tracee's working
+ * directory or directory file descriptor.  The ordering is the global order in
+ * which syscalls return.
+ *
+ * ./workload-record build.trace make -j8
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/openat2.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "workload-trace.h"
+
+#define MAX_THREADS 4096
+
+struct thread {
+	/* 0 if unused, -1 if removed. */
+	pid_t tid;
+	/* A record is pending until the syscall returns. */
+	bool pending;
+	bool addr2_is_path;
+	struct workload_record rec;
+	char path[PATH_MAX];
+	char path2[PATH_MAX];
+};
+
+static struct thread *threads[MAX_THREADS];
+static unsigned long long nb_records;
+
+/* Returns the thread state, created if needed, or NULL if full. */
+static struct thread *get_thread(const pid_t tid, bool *const created)
+{
+	size_t i, slot = MAX_THREADS;
+
+	*created = false;
+	for (i = 0; i < MAX_THREADS; i++) {
+		struct thread *const t = threads[(tid + i) % MAX_THREADS];
+
+		if (!t) {
+			if (slot == MAX_THREADS)
+				slot = (tid + i) % MAX_THREADS;
+			break;
+		}
+		if (t->tid == tid)
+			return t;
+		if (t->tid == -1 && slot == MAX_THREADS)
+			slot = (tid + i) % MAX_THREADS;
+	}
+	if (slot == MAX_THREADS)
+		return NULL;
+
+	if (!threads[slot]) {
+		threads[slot] = calloc(1, sizeof(*threads[slot]));
+		if (!threads[slot])
+			return NULL;
+	}
+	threads[slot]->tid = tid;
+	threads[slot]->pending = false;
+	*created = true;
+	return threads[slot];
+}
+
+static void remove_thread(const pid_t tid)
+{
+	size_t i;
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		struct thread *const t = threads[(tid + i) % MAX_THREADS];
+
+		if (!t)
+			return;
+		if (t->tid == tid) {
+			t->tid = -1;
+			return;
+		}
+	}
+}
+
+static int read_mem(const pid_t tid, const unsigned long long addr,
+		    void *const buf, const size_t size)
+{
+	struct iovec local = { .iov_base = buf, .iov_len = size };
+	struct iovec remote = { .iov_base = (void *)addr, .iov_len = size };
+
+	if (process_vm_readv(tid, &local, 1, &remote, 1, 0) != (ssize_t)size)
+		return -1;
+	return 0;
+}
+
+/* Reads a NUL-terminated string, without crossing unmapped pages. */
+static int read_string(const pid_t tid, unsigned long long addr, char *buf,
+		       size_t size)
+{
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+
+	while (size > 1) {
+		size_t len = page_size - (addr % page_size);
+		char *end;
+
+		if (len > size - 1)
+			len = size - 1;
+		if (read_mem(tid, addr, buf, len))
+			return -1;
+		end = memchr(buf, '\0', len);
+		if (end)
+			return 0;
+		addr += len;
+		buf += len;
+		size -= len;
+	}
+	*buf = '\0';
+	return -1;
+}
+
+/* Reads a path and makes it absolute according to the tracee's view. */
+static int read_path(const pid_t tid, const int dirfd,
+		     const unsigned long long addr, char *const path)
+{
+	char rel[PATH_MAX], link[64], base[PATH_MAX];
+	ssize_t len;
+
+	if (read_string(tid, addr, rel, sizeof(rel)))
+		return -1;
+
+	if (rel[0] == '/') {
+		strcpy(path, rel);
+		return 0;
+	}
+
+	if (dirfd == AT_FDCWD)
+		snprintf(link, sizeof(link), "/proc/%d/cwd", tid);
+	else
+		snprintf(link, sizeof(link), "/proc/%d/fd/%d", tid, dirfd);
+
+	len = readlink(link, base, sizeof(base) - 1);
+	if (len < 0)
+		return -1;
+	base[len] = '\0';
+
+	if (!rel[0])
+		strcpy(path, base);
+	else if (snprintf(path, PATH_MAX, "%s%s%s", base,
+			  strcmp(base, "/") ? "/" : "", rel) >= PATH_MAX)
+		return -1;
+	return 0;
+}
+
+static int read_sockaddr(const pid_t tid, const unsigned long long addr,
+			 const unsigned long long addrlen,
+			 struct workload_record *const rec)
+{
+	struct sockaddr_in6 sa = {};
+	const size_t len = addrlen < sizeof(sa) ? addrlen : sizeof(sa);
+
+	if (len < sizeof(sa_family_t) || read_mem(tid, addr, &sa, len))
+		return -1;
+
+	switch (sa.sin6_family) {
+	case AF_INET:
+	case AF_INET6:
+		/* Same port offset for both families. */
+		rec->flags = sa.sin6_family;
+		rec->port = ntohs(sa.sin6_port);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Fills the pending record at syscall entry, when the arguments are still
+ * readable (e.g. before execve replaces the memory).
+ */
+static void syscall_entry(struct thread *const t,
+			  const struct __ptrace_syscall_info *const info)
+{
+	const uint64_t *const args = info->entry.args;
+	struct workload_record *const rec = &t->rec;
+	int dirfd = AT_FDCWD, dirfd2 = AT_FDCWD;
+	unsigned long long addr = 0, addr2 = 0;
+	struct open_how how;
+
+	memset(rec, 0, sizeof(*rec));
+	t->pending = false;
+	t->addr2_is_path = true;
+	t->path[0] = '\0';
+	t->path2[0] = '\0';
+
+	switch (info->entry.nr) {
+#ifdef SYS_open
+	case SYS_open:
+		rec->op = WORKLOAD_OP_OPEN;
+		addr = args[0];
+		rec->flags = args[1];
+		rec->mode = args[2];
+		break;
+#endif
+#ifdef SYS_creat
+	case SYS_creat:
+		rec->op = WORKLOAD_OP_OPEN;
+		addr = args[0];
+		rec->flags = O_CREAT | O_WRONLY | O_TRUNC;
+		rec->mode = args[1];
+		break;
+#endif
+	case SYS_openat:
+		rec->op = WORKLOAD_OP_OPEN;
+		dirfd = args[0];
+		addr = args[1];
+		rec->flags = args[2];
+		rec->mode = args[3];
+		break;
+#ifdef SYS_openat2
+	case SYS_openat2:
+		rec->op = WORKLOAD_OP_OPEN;
+		dirfd = args[0];
+		addr = args[1];
+		break;
+#endif
+#ifdef SYS_stat
+	case SYS_stat:
+		rec->op = WORKLOAD_OP_STAT;
+		addr = args[0];
+		break;
+#endif
+#ifdef SYS_lstat
+	case SYS_lstat:
+		rec->op = WORKLOAD_OP_STAT;
+		addr = args[0];
+		rec->flags = AT_SYMLINK_NOFOLLOW;
+		break;
+#endif
+#ifdef SYS_newfstatat
+	case SYS_newfstatat:
+		rec->op = WORKLOAD_OP_STAT;
+		dirfd = args[0];
+		addr = args[1];
+		rec->flags = args[3] & AT_SYMLINK_NOFOLLOW;
+		if (args[3] & AT_EMPTY_PATH)
+			return;
+		break;
+#endif
+	case SYS_statx:
+		rec->op = WORKLOAD_OP_STAT;
+		dirfd = args[0];
+		addr = args[1];
+		rec->flags = args[2] & AT_SYMLINK_NOFOLLOW;
+		if (args[2] & AT_EMPTY_PATH)
+			return;
+		break;
+#ifdef SYS_access
+	case SYS_access:
+		rec->op = WORKLOAD_OP_ACCESS;
+		addr = args[0];
+		rec->flags = args[1];
+		break;
+#endif
+	case SYS_faccessat:
+#ifdef SYS_faccessat2
+	case SYS_faccessat2:
+#endif
+		rec->op = WORKLOAD_OP_ACCESS;
+		dirfd = args[0];
+		addr = args[1];
+		rec->flags = args[2];
+		break;
+#ifdef SYS_readlink
+	case SYS_readlink:
+		rec->op = WORKLOAD_OP_READLINK;
+		addr = args[0];
+		break;
+#endif
+	case SYS_readlinkat:
+		rec->op = WORKLOAD_OP_READLINK;
+		dirfd = args[0];
+		addr = args[1];
+		break;
+	case SYS_execve:
+		rec->op = WORKLOAD_OP_EXEC;
+		addr = args[0];
+		break;
+	case SYS_execveat:
+		rec->op = WORKLOAD_OP_EXEC;
+		dirfd = args[0];
+		addr = args[1];
+		if (args[4] & AT_EMPTY_PATH)
+			return;
+		break;
+#ifdef SYS_mkdir
+	case SYS_mkdir:
+		rec->op = WORKLOAD_OP_MKDIR;
+		addr = args[0];
+		rec->mode = args[1];
+		break;
+#endif
+	case SYS_mkdirat:
+		rec->op = WORKLOAD_OP_MKDIR;
+		dirfd = args[0];
+		addr = args[1];
+		rec->mode = args[2];
+		break;
+#ifdef SYS_mknod
+	case SYS_mknod:
+		rec->op = WORKLOAD_OP_MKNOD;
+		addr = args[0];
+		rec->mode = args[1];
+		break;
+#endif
+	case SYS_mknodat:
+		rec->op = WORKLOAD_OP_MKNOD;
+		dirfd = args[0];
+		addr = args[1];
+		rec->mode = args[2];
+		break;
+#ifdef SYS_rmdir
+	case SYS_rmdir:
+		rec->op = WORKLOAD_OP_RMDIR;
+		addr = args[0];
+		break;
+#endif
+#ifdef SYS_unlink
+	case SYS_unlink:
+		rec->op = WORKLOAD_OP_UNLINK;
+		addr = args[0];
+		break;
+#endif
+	case SYS_unlinkat:
+		rec->op = (args[2] & AT_REMOVEDIR) ? WORKLOAD_OP_RMDIR :
+						     WORKLOAD_OP_UNLINK;
+		dirfd = args[0];
+		addr = args[1];
+		break;
+#ifdef SYS_rename
+	case SYS_rename:
+		rec->op = WORKLOAD_OP_RENAME;
+		addr = args[0];
+		addr2 = args[1];
+		break;
+#endif
+#ifdef SYS_renameat
+	case SYS_renameat:
+#endif
+	case SYS_renameat2:
+		rec->op = WORKLOAD_OP_RENAME;
+		dirfd = args[0];
+		addr = args[1];
+		dirfd2 = args[2];
+		addr2 = args[3];
+		if (info->entry.nr == SYS_renameat2)
+			rec->flags = args[4];
+		break;
+#ifdef SYS_link
+	case SYS_link:
+		rec->op = WORKLOAD_OP_LINK;
+		addr = args[0];
+		addr2 = args[1];
+		break;
+#endif
+	case SYS_linkat:
+		rec->op = WORKLOAD_OP_LINK;
+		dirfd = args[0];
+		addr = args[1];
+		dirfd2 = args[2];
+		addr2 = args[3];
+		break;
+#ifdef SYS_symlink
+	case SYS_symlink:
+		rec->op = WORKLOAD_OP_SYMLINK;
+		addr2 = args[0];
+		addr = args[1];
+		t->addr2_is_path = false;
+		break;
+#endif
+	case SYS_symlinkat:
+		rec->op = WORKLOAD_OP_SYMLINK;
+		addr2 = args[0];
+		dirfd = args[1];
+		addr = args[2];
+		t->addr2_is_path = false;
+		break;
+	case SYS_truncate:
+		rec->op = WORKLOAD_OP_TRUNCATE;
+		addr = args[0];
+		break;
+	case SYS_connect:
+	case SYS_bind:
+		rec->op = (info->entry.nr == SYS_connect) ? WORKLOAD_OP_CONNECT :
+							    WORKLOAD_OP_BIND;
+		if (read_sockaddr(t->tid, args[1], args[2], rec))
+			return;
+		t->pending = true;
+		return;
+	default:
+		return;
+	}
+
+#ifdef SYS_openat2
+	if (info->entry.nr == SYS_openat2) {
+		memset(&how, 0, sizeof(how));
+		if (read_mem(t->tid, args[2],
+			     &how, args[3] < sizeof(how) ? args[3] : sizeof(how)))
+			return;
+		rec->flags = how.flags;
+		rec->mode = how.mode;
+	}
+#endif
+
+	if (read_path(t->tid, dirfd, addr, t->path))
+		return;
+
+	if (addr2) {
+		if (t->addr2_is_path) {
+			if (read_path(t->tid, dirfd2, addr2, t->path2))
+				return;
+		} else if (read_string(t->tid, addr2, t->path2,
+				       sizeof(t->path2))) {
+			return;
+		}
+	}
+	t->pending = true;
+}
+
+static void syscall_exit(FILE *const out, struct thread *const t,
+			 const struct __ptrace_syscall_info *const info)
+{
+	struct workload_record *const rec = &t->rec;
+	const char *type_path = t->path;
+	struct stat st;
+
+	if (!t->pending)
+		return;
+	t->pending = false;
+
+	rec->error = info->exit.is_error ? -info->exit.rval : 0;
+
+	/* Records the type of the (moved) file, if it exists. */
+	if (rec->op == WORKLOAD_OP_RENAME && !rec->error)
+		type_path = t->path2;
+	if (rec->op == WORKLOAD_OP_RMDIR)
+		rec->type = S_IFDIR;
+	else if (type_path[0] && !lstat(type_path, &st))
+		rec->type = st.st_mode & S_IFMT;
+
+	/* Keeps the target of pre-existing symlinks to replicate them. */
+	if (rec->type == S_IFLNK && !t->path2[0]) {
+		const ssize_t len =
+			readlink(t->path, t->path2, sizeof(t->path2) - 1);
+
+		t->path2[len < 0 ? 0 : len] = '\0';
+	}
+
+	rec->path_len = strlen(t->path);
+	rec->path2_len = strlen(t->path2);
+	if (fwrite(rec, sizeof(*rec), 1, out) != 1 ||
+	    fwrite(t->path, 1, rec->path_len, out) != rec->path_len ||
+	    fwrite(t->path2, 1, rec->path2_len, out) != rec->path2_len) {
+		perror("Failed to write the trace");
+		exit(1);
+	}
+	nb_records++;
+}
+
+static void handle_syscall(FILE *const out, struct thread *const t)
+{
+	struct __ptrace_syscall_info info;
+
+	if (ptrace(PTRACE_GET_SYSCALL_INFO, t->tid, sizeof(info), &info) < 0)
+		return;
+
+	switch (info.op) {
+	case PTRACE_SYSCALL_INFO_ENTRY:
+		syscall_entry(t, &info);
+		break;
+	case PTRACE_SYSCALL_INFO_EXIT:
+		syscall_exit(out, t, &info);
+		break;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *out;
+	pid_t child;
+	int status, ret = 1;
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s <trace-file> <command> [arg]...\n",
+			argv[0]);
+		return 1;
+	}
+
+	out = fopen(argv[1], "w");
+	if (!out) {
+		perror("Failed to create the trace file");
+		return 1;
+	}
+	fwrite(WORKLOAD_TRACE_MAGIC, 1, strlen(WORKLOAD_TRACE_MAGIC), out);
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return 1;
+	}
+	if (!child) {
+		if (ptrace(PTRACE_TRACEME, 0, NULL, NULL)) {
+			perror("Failed to ptrace");
+			_exit(1);
+		}
+		raise(SIGSTOP);
+		execvp(argv[2], argv + 2);
+		perror("Failed to execute the command");
+		_exit(127);
+	}
+
+	if (waitpid(child, &status, 0) != child || !WIFSTOPPED(status)) {
+		fprintf(stderr, "Failed to start the command\n");
+		return 1;
+	}
+	if (ptrace(PTRACE_SETOPTIONS, child, NULL,
+		   PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEFORK |
+			   PTRACE_O_TRACEVFORK | PTRACE_O_TRACECLONE |
+			   PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL)) {
+		perror("Failed to set ptrace options");
+		return 1;
+	}
+	ptrace(PTRACE_SYSCALL, child, NULL, NULL);
+
+	while (true) {
+		struct thread *t;
+		bool created;
+		int sig;
+		const pid_t tid = waitpid(-1, &status, __WALL);
+
+		if (tid < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ECHILD)
+				break;
+			perror("Failed to wait");
+			return 1;
+		}
+
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			if (tid == child)
+				ret = WIFEXITED(status) ?
+					      WEXITSTATUS(status) :
+					      128 + WTERMSIG(status);
+			remove_thread(tid);
+			continue;
+		}
+		if (!WIFSTOPPED(status))
+			continue;
+
+		t = get_thread(tid, &created);
+		if (!t) {
+			fprintf(stderr, "Too many threads\n");
+			return 1;
+		}
+
+		sig = WSTOPSIG(status);
+		if (sig == (SIGTRAP | 0x80)) {
+			handle_syscall(out, t);
+			sig = 0;
+		} else if (status >> 16) {
+			/* fork, clone or exec events. */
+			sig = 0;
+		} else if (sig == SIGSTOP && created) {
+			/* Initial stop of a new thread or process. */
+			sig = 0;
+		}
+		ptrace(PTRACE_SYSCALL, tid, NULL, sig);
+	}
+
+	if (fclose(out)) {
+		perror("Failed to write the trace");
+		return 1;
+	}
+	fprintf(stderr, "[*] Recorded %llu syscalls in %s\n", nb_records,
+		argv[1]);
+	return ret;
+}
@@ -0,0 +1,658 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * workload-replay [-n runs] [-s] [-d] <trace-file>
+ *
+ * Replay a trace recorded with workload-record, at full speed, against a
+ * tmpfs replica of the files it accessed.  With -s, runs alternate between no
+ * sandbox and a sandbox built from the LL_FS_RO and LL_FS_RW environment
+ * variables (as the sandboxer), which are interpreted in the replica.  With -d,
+ * only dump the trace.
+ *
+ * Each run gets a fresh replica, in a dedicated user, mount and network
+ * namespace, where pre-existing files (according to the first operation on
+ * each path) are created empty, with their parent directories.  The replica
+ * is then used as root directory.  Executions are replayed as opens, and
+ * network operations use the loopback interface.
+ *
+ * LL_FS_RO=/ LL_FS_RW=/tmp ./workload-replay -n 5 -s build.trace
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "landlock-helpers.h"
+#include "workload-trace.h"
+
+#define WORKLOAD_OP_NAME(name) #name,
+
+static const char *const op_names[] = { WORKLOAD_OPS(WORKLOAD_OP_NAME) };
+
+struct entry {
+	struct workload_record rec;
+	char *path;
+	char *path2;
+};
+
+struct trace {
+	struct entry *entries;
+	size_t len;
+};
+
+struct run_stats {
+	unsigned long long count[WORKLOAD_OP_MAX];
+	unsigned long long ns[WORKLOAD_OP_MAX];
+	unsigned long long mismatches[WORKLOAD_OP_MAX];
+};
+
+static char *read_string(FILE *const in, const size_t len)
+{
+	char *const str = malloc(len + 1);
+
+	if (!str)
+		return NULL;
+	if (fread(str, 1, len, in) != len) {
+		free(str);
+		return NULL;
+	}
+	str[len] = '\0';
+	return str;
+}
+
+static int load_trace(const char *const file, struct trace *const trace)
+{
+	char magic[sizeof(WORKLOAD_TRACE_MAGIC) - 1];
+	size_t capacity = 0;
+	FILE *const in = fopen(file, "r");
+
+	if (!in) {
+		perror("Failed to open the trace");
+		return -1;
+	}
+	if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+	    memcmp(magic, WORKLOAD_TRACE_MAGIC, sizeof(magic))) {
+		fprintf(stderr, "Invalid trace format\n");
+		fclose(in);
+		return -1;
+	}
+
+	memset(trace, 0, sizeof(*trace));
+	while (true) {
+		struct entry *e;
+
+		if (trace->len == capacity) {
+			capacity = capacity ? capacity * 2 : 1024;
+			e = realloc(trace->entries,
+				    capacity * sizeof(*trace->entries));
+			if (!e) {
+				perror("Failed to load the trace");
+				fclose(in);
+				return -1;
+			}
+			trace->entries = e;
+		}
+		e = &trace->entries[trace->len];
+		if (fread(&e->rec, sizeof(e->rec), 1, in) != 1)
+			break;
+
+		e->path = read_string(in, e->rec.path_len);
+		e->path2 = read_string(in, e->rec.path2_len);
+		if (!e->path || !e->path2 || e->rec.op >= WORKLOAD_OP_MAX) {
+			fprintf(stderr, "Truncated or invalid trace\n");
+			fclose(in);
+			return -1;
+		}
+		trace->len++;
+	}
+	fclose(in);
+	return 0;
+}
+
+static void dump_trace(const struct trace *const trace)
+{
+	size_t i;
+
+	for (i = 0; i < trace->len; i++) {
+		const struct entry *const e = &trace->entries[i];
+
+		printf("%-8s flags=0x%x mode=0%o type=0%o port=%u error=%d %s%s%s\n",
+		       op_names[e->rec.op], e->rec.flags, e->rec.mode,
+		       e->rec.type, e->rec.port, e->rec.error, e->path,
+		       e->path2[0] ? " " : "", e->path2);
+	}
+}
+
+/* Set of paths already seen while populating the replica. */
+struct path_set {
+	const char **slots;
+	size_t size;
+};
+
+static uint64_t hash_path(const char *s)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (*s)
+		h = (h ^ (unsigned char)*s++) * 0x100000001b3ULL;
+	return h;
+}
+
+/* Returns true if the path was already in the set. */
+static bool path_set_add(struct path_set *const set, const char *const path)
+{
+	size_t i = hash_path(path) % set->size;
+
+	while (set->slots[i]) {
+		if (!strcmp(set->slots[i], path))
+			return true;
+		i = (i + 1) % set->size;
+	}
+	set->slots[i] = path;
+	return false;
+}
+
+static void mkdir_parents(char *const path)
+{
+	char *p;
+
+	for (p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		mkdir(path, 0755);
+		*p = '/';
+	}
+}
+
+static void create_file(const char *const root, const char *const path,
+			const uint32_t type, const char *const target)
+{
+	char full[PATH_MAX * 2];
+	int fd;
+
+	if (snprintf(full, sizeof(full), "%s%s", root, path) >= sizeof(full))
+		return;
+	mkdir_parents(full);
+
+	switch (type) {
+	case S_IFDIR:
+		mkdir(full, 0755);
+		break;
+	case S_IFLNK:
+		symlink(target[0] ? target : "/nonexistent", full);
+		break;
+	default:
+		/* Devices, FIFOs and sockets are replicated as regular files. */
+		fd = open(full, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (fd >= 0)
+			close(fd);
+		break;
+	}
+}
+
+/* Infers whether a path existed before its first operation, and its type. */
+static bool existed_before(const struct entry *const e, const bool second,
+			   uint32_t *const type)
+{
+	const struct workload_record *const rec = &e->rec;
+
+	*type = rec->type;
+	if (rec->error == ENOENT || rec->error == ENOTDIR)
+		return false;
+
+	switch (rec->op) {
+	case WORKLOAD_OP_OPEN:
+		if ((rec->flags & O_CREAT) && (rec->flags & O_EXCL) &&
+		    !rec->error)
+			return false;
+		if (rec->flags & O_DIRECTORY)
+			*type = S_IFDIR;
+		break;
+	case WORKLOAD_OP_MKDIR:
+		*type = S_IFDIR;
+		/* fall through */
+	case WORKLOAD_OP_MKNOD:
+	case WORKLOAD_OP_SYMLINK:
+		return !!rec->error;
+	case WORKLOAD_OP_RMDIR:
+		*type = S_IFDIR;
+		break;
+	case WORKLOAD_OP_RENAME:
+	case WORKLOAD_OP_LINK:
+		/* The destination is assumed to be new. */
+		if (second)
+			return !!rec->error;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+static void populate(const char *const root, const struct trace *const trace)
+{
+	struct path_set set = {};
+	size_t i;
+	uint32_t type;
+
+	set.size = trace->len * 4 + 1;
+	set.slots = calloc(set.size, sizeof(*set.slots));
+	if (!set.slots) {
+		perror("Failed to populate the replica");
+		exit(1);
+	}
+
+	for (i = 0; i < trace->len; i++) {
+		const struct entry *const e = &trace->entries[i];
+
+		if (!e->path[0])
+			continue;
+
+		if (!path_set_add(&set, e->path) &&
+		    existed_before(e, false, &type))
+			create_file(root, e->path, type,
+				    type == S_IFLNK ? e->path2 : "");
+
+		if ((e->rec.op == WORKLOAD_OP_RENAME ||
+		     e->rec.op == WORKLOAD_OP_LINK) &&
+		    !path_set_add(&set, e->path2) &&
+		    existed_before(e, true, &type))
+			create_file(root, e->path2, type, "");
+	}
+	free(set.slots);
+}
+
+static int replay_net(const struct workload_record *const rec)
+{
+	struct sockaddr_in6 sa6 = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(rec->port),
+		.sin6_addr = IN6ADDR_LOOPBACK_INIT,
+	};
+	struct sockaddr_in sa4 = {
+		.sin_family = AF_INET,
+		.sin_port = htons(rec->port),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	const bool ipv6 = rec->flags == AF_INET6;
+	const struct sockaddr *const sa = ipv6 ? (struct sockaddr *)&sa6 :
+						 (struct sockaddr *)&sa4;
+	const socklen_t len = ipv6 ? sizeof(sa6) : sizeof(sa4);
+	int fd, ret, err;
+
+	fd = socket(rec->flags, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+	if (rec->op == WORKLOAD_OP_CONNECT)
+		ret = connect(fd, sa, len);
+	else
+		ret = bind(fd, sa, len);
+	err = errno;
+	close(fd);
+	errno = err;
+	return ret;
+}
+
+/* Returns the resulting errno, or 0. */
+static int replay_one(const struct entry *const e)
+{
+	const struct workload_record *const rec = &e->rec;
+	struct stat st;
+	char buf[PATH_MAX];
+	int ret;
+
+	switch (rec->op) {
+	case WORKLOAD_OP_OPEN:
+		ret = open(e->path, rec->flags | O_CLOEXEC, rec->mode);
+		if (ret >= 0)
+			close(ret);
+		break;
+	case WORKLOAD_OP_EXEC:
+		ret = open(e->path, O_RDONLY | O_CLOEXEC);
+		if (ret >= 0)
+			close(ret);
+		break;
+	case WORKLOAD_OP_STAT:
+		ret = fstatat(AT_FDCWD, e->path, &st, rec->flags);
+		break;
+	case WORKLOAD_OP_ACCESS:
+		ret = faccessat(AT_FDCWD, e->path, rec->flags, 0);
+		break;
+	case WORKLOAD_OP_READLINK:
+		ret = readlink(e->path, buf, sizeof(buf));
+		break;
+	case WORKLOAD_OP_MKDIR:
+		ret = mkdir(e->path, rec->mode);
+		break;
+	case WORKLOAD_OP_MKNOD:
+		ret = mknod(e->path, rec->mode, 0);
+		break;
+	case WORKLOAD_OP_RMDIR:
+		ret = rmdir(e->path);
+		break;
+	case WORKLOAD_OP_UNLINK:
+		ret = unlink(e->path);
+		break;
+	case WORKLOAD_OP_RENAME:
+		ret = syscall(SYS_renameat2, AT_FDCWD, e->path, AT_FDCWD,
+			      e->path2, rec->flags);
+		break;
+	case WORKLOAD_OP_LINK:
+		ret = link(e->path, e->path2);
+		break;
+	case WORKLOAD_OP_SYMLINK:
+		ret = symlink(e->path2, e->path);
+		break;
+	case WORKLOAD_OP_TRUNCATE:
+		ret = truncate(e->path, 0);
+		break;
+	case WORKLOAD_OP_CONNECT:
+	case WORKLOAD_OP_BIND:
+		ret = replay_net(rec);
+		if (ret && errno == EINPROGRESS)
+			ret = 0;
+		break;
+	default:
+		return 0;
+	}
+	return ret < 0 ? errno : 0;
+}
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void replay(const struct trace *const trace,
+		   struct run_stats *const stats)
+{
+	size_t i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < trace->len; i++) {
+		const struct entry *const e = &trace->entries[i];
+		const unsigned long long start = now_ns();
+		const int err = replay_one(e);
+
+		stats->ns[e->rec.op] += now_ns() - start;
+		stats->count[e->rec.op]++;
+		if (err != e->rec.error)
+			stats->mismatches[e->rec.op]++;
+	}
+}
+
+static int write_file(const char *const path, const char *const content)
+{
+	const int fd = open(path, O_WRONLY | O_CLOEXEC);
+	ssize_t len;
+
+	if (fd < 0)
+		return -1;
+	len = write(fd, content, strlen(content));
+	close(fd);
+	return len == (ssize_t)strlen(content) ? 0 : -1;
+}
+
+static int setup_namespaces(void)
+{
+	const uid_t uid = geteuid();
+	const gid_t gid = getegid();
+	char map[64];
+	struct ifreq ifr = {};
+	int fd;
+
+	if (unshare(CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWNET)) {
+		perror("Failed to create namespaces");
+		return -1;
+	}
+
+	snprintf(map, sizeof(map), "0 %u 1", uid);
+	if (write_file("/proc/self/uid_map", map) ||
+	    write_file("/proc/self/setgroups", "deny")) {
+		perror("Failed to map user");
+		return -1;
+	}
+	snprintf(map, sizeof(map), "0 %u 1", gid);
+	if (write_file("/proc/self/gid_map", map)) {
+		perror("Failed to map group");
+		return -1;
+	}
+
+	if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL)) {
+		perror("Failed to make mounts private");
+		return -1;
+	}
+
+	/* Brings up the loopback interface for network operations. */
+	fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd >= 0) {
+		strcpy(ifr.ifr_name, "lo");
+		if (!ioctl(fd, SIOCGIFFLAGS, &ifr)) {
+			ifr.ifr_flags |= IFF_UP;
+			ioctl(fd, SIOCSIFFLAGS, &ifr);
+		}
+		close(fd);
+	}
+	return 0;
+}
+
+/* Replays the trace in a fresh replica, in a child process. */
+static int run(const char *const root, const struct trace *const trace,
+	       const bool sandbox, struct run_stats *const stats)
+{
+	int pipefd[2], status;
+	bool received;
+	pid_t child;
+
+	if (mount("tmpfs", root, "tmpfs", 0, "mode=755")) {
+		perror("Failed to mount the replica");
+		return -1;
+	}
+	populate(root, trace);
+
+	if (pipe2(pipefd, O_CLOEXEC)) {
+		perror("Failed to create pipe");
+		return -1;
+	}
+
+	child = fork();
+	if (child < 0) {
+		perror("Failed to fork");
+		return -1;
+	}
+	if (!child) {
+		close(pipefd[0]);
+		if (chroot(root) || chdir("/")) {
+			perror("Failed to enter the replica");
+			_exit(1);
+		}
+		if (sandbox && ll_sandbox_from_env()) {
+			perror("Failed to sandbox");
+			_exit(1);
+		}
+		replay(trace, stats);
+		if (write(pipefd[1], stats, sizeof(*stats)) != sizeof(*stats))
+			_exit(1);
+		_exit(0);
+	}
+
+	close(pipefd[1]);
+	received = read(pipefd[0], stats, sizeof(*stats)) == sizeof(*stats);
+	close(pipefd[0]);
+	waitpid(child, &status, 0);
+
+	if (umount2(root, MNT_DETACH)) {
+		perror("Failed to unmount the replica");
+		return -1;
+	}
+	if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+	return 0;
+}
+
+static void sort_ull(unsigned long long *const values, const size_t len)
+{
+	size_t i, j;
+
+	for (i = 1; i < len; i++) {
+		const unsigned long long v = values[i];
+
+		for (j = i; j > 0 && values[j - 1] > v; j--)
+			values[j] = values[j - 1];
+		values[j] = v;
+	}
+}
+
+/* Median of the per-operation time of several runs. */
+static unsigned long long median_ns(const struct run_stats *const runs,
+				    const size_t nb_runs, const int op)
+{
+	unsigned long long values[nb_runs];
+	size_t i;
+
+	for (i = 0; i < nb_runs; i++) {
+		values[i] = 0;
+		if (op < 0) {
+			int j;
+
+			for (j = 0; j < WORKLOAD_OP_MAX; j++)
+				values[i] += runs[i].ns[j];
+		} else {
+			values[i] = runs[i].ns[op];
+		}
+	}
+	sort_ull(values, nb_runs);
+	return values[nb_runs / 2];
+}
+
+static void print_summary(const struct run_stats *const base,
+			  const struct run_stats *const sandbox,
+			  const size_t nb_runs)
+{
+	unsigned long long total = 0;
+	double b, s = 0;
+	int op;
+
+	printf("[*] Median per operation over %zu runs:\n", nb_runs);
+	printf("%-10s %10s %12s %12s %10s %12s\n", "op", "count", "base(ns)",
+	       "sandbox(ns)", "overhead", "mismatches");
+	for (op = 0; op < WORKLOAD_OP_MAX; op++) {
+		const unsigned long long count = base[0].count[op];
+
+		if (!count)
+			continue;
+		total += count;
+		b = median_ns(base, nb_runs, op);
+		if (sandbox)
+			s = median_ns(sandbox, nb_runs, op);
+		printf("%-10s %10llu %12.1f %12.1f %9.1f%% %12llu\n",
+		       op_names[op], count, b / count, s / count,
+		       sandbox && b ? 100 * (s - b) / b : 0,
+		       sandbox ? sandbox[0].mismatches[op] :
+				 base[0].mismatches[op]);
+	}
+	if (!total)
+		return;
+
+	b = median_ns(base, nb_runs, -1);
+	if (sandbox)
+		s = median_ns(sandbox, nb_runs, -1);
+	printf("%-10s %10llu %12.1f %12.1f %9.1f%%\n", "TOTAL", total,
+	       b / total, s / total, sandbox && b ? 100 * (s - b) / b : 0);
+}
+
+int main(int argc, char *argv[])
+{
+	struct trace trace;
+	struct run_stats *base, *sandboxed = NULL;
+	char root[] = "/tmp/workload-replay.XXXXXX";
+	int opt, nb_runs = 3, i, ret = 1;
+	bool sandbox = false, dump = false;
+
+	while ((opt = getopt(argc, argv, "n:sd")) != -1) {
+		switch (opt) {
+		case 'n':
+			nb_runs = atoi(optarg);
+			break;
+		case 's':
+			sandbox = true;
+			break;
+		case 'd':
+			dump = true;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc - 1 || nb_runs <= 0)
+		goto usage;
+
+	if (load_trace(argv[optind], &trace))
+		return 1;
+
+	if (dump) {
+		dump_trace(&trace);
+		return 0;
+	}
+
+	base = calloc(nb_runs, sizeof(*base));
+	if (sandbox)
+		sandboxed = calloc(nb_runs, sizeof(*sandboxed));
+	if (!base || (sandbox && !sandboxed)) {
+		perror("Failed to allocate");
+		return 1;
+	}
+
+	if (!mkdtemp(root)) {
+		perror("Failed to create the replica directory");
+		return 1;
+	}
+	if (setup_namespaces())
+		goto out;
+
+	printf("[*] Replaying %zu operations\n", trace.len);
+	for (i = 0; i < nb_runs; i++) {
+		if (run(root, &trace, false, &base[i]))
+			goto out;
+		printf("[*] run %d without sandbox: %.1f ms\n", i + 1,
+		       median_ns(&base[i], 1, -1) / 1e6);
+		if (!sandbox)
+			continue;
+		if (run(root, &trace, true, &sandboxed[i]))
+			goto out;
+		printf("[*] run %d with sandbox: %.1f ms\n", i + 1,
+		       median_ns(&sandboxed[i], 1, -1) / 1e6);
+	}
+	print_summary(base, sandboxed, nb_runs);
+	ret = 0;
+
+out:
+	rmdir(root);
+	return ret;
+
+usage:
+	fprintf(stderr, "usage: %s [-n runs] [-s] [-d] <trace-file>\n",
+		argv[0]);
+	return 1;
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Trace format shared by workload-record.c and workload-replay.c
+ *
+ * A trace starts with WORKLOAD_TRACE_MAGIC, followed by records, each one
+ * immediately followed by its path and path2 strings (not NUL-terminated).
+ * Records are in host endianness: traces are replayed on the same
+ * architecture.
+ *
+ * Copyright © 2025 Mickaël Salaün <mic@digikod.net>.
+ */
+
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include <stdint.h>
+
+#define WORKLOAD_TRACE_MAGIC "LLTRACE1"
+
+/* Operations, independent of the syscall variant (e.g. open vs. openat). */
+#define WORKLOAD_OPS(X)   \
+	X(OPEN)           \
+	X(STAT)           \
+	X(ACCESS)         \
+	X(READLINK)       \
+	X(EXEC)           \
+	X(MKDIR)          \
+	X(MKNOD)          \
+	X(RMDIR)          \
+	X(UNLINK)         \
+	X(RENAME)         \
+	X(LINK)           \
+	X(SYMLINK)        \
+	X(TRUNCATE)       \
+	X(CONNECT)        \
+	X(BIND)
+
+#define WORKLOAD_OP_ENUM(name) WORKLOAD_OP_##name,
+
+enum workload_op { WORKLOAD_OPS(WORKLOAD_OP_ENUM) WORKLOAD_OP_MAX };
+
+struct workload_record {
+	/* One of enum workload_op. */
+	uint16_t op;
+	/* Length of the absolute path (or 0 for network operations). */
+	uint16_t path_len;
+	/*
+	 * Length of the second path: the new path for RENAME and LINK, the
+	 * target for SYMLINK, or the target of a pre-existing symlink.
+	 */
+	uint16_t path2_len;
+	/* Network port for CONNECT and BIND. */
+	uint16_t port;
+	/*
+	 * Operation flags: open(2) flags for OPEN, AT_* flags for STAT, access
+	 * mode for ACCESS, renameat2(2) flags for RENAME, address family for
+	 * CONNECT and BIND.
+	 */
+	uint32_t flags;
+	/* File mode for OPEN, MKDIR and MKNOD. */
+	uint32_t mode;
+	/* File type (S_IFMT) of the path when it existed, or 0. */
+	uint32_t type;
+	/* Recorded errno, or 0 on success. */
+	int32_t error;
+} __attribute__((packed));
+
+#endif /* WORKLOAD_TRACE_H */
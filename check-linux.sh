@@ -298,16 +298,53 @@ build_kselftest() {
 	make_cmd "${MAKE_ARGS[@]}" "${static_build[@]}" install
 }
 
-run_kselftest_uml() {
-	local timeout=60
+# Prints the results streamed by the guest, even if it was killed.
+print_kselftest_results() {
+	local results="$1"
+
+	if [[ ! -f "${results}/results.tap" ]]; then
+		echo "[-] No test result recorded"
+		return
+	fi
+
+	echo "[*] Results: $(grep -c '^ok ' -- "${results}/results.tap" || :) passed, $(grep -c '^not ok ' -- "${results}/results.tap" || :) failed (cf. ${results})"
+	grep '^not ok ' -- "${results}/results.tap" || :
+	grep '^Bail out!' -- "${results}/results.tap" || :
+	if ! grep -q '^1\.\.' -- "${results}/results.tap"; then
+		echo "[-] Incomplete results"
+	fi
+}
+
+# Arguments: runner script, kernel, and timeout in seconds.
+run_kselftest_vm() {
+	local runner="$1"
+	local kernel="$2"
+	local timeout="$3"
+	local results="$(readlink -f -- "${O}")/kselftest/results"
+	local ret=0
+
+	rm -rf -- "${results}"
+	mkdir -p -- "${results}"
 
 	# TODO: Use ./run_kselftest.sh --summary while catching test errors.
-	timeout --signal KILL "${timeout}" </dev/null 2>&1 "${BASE_DIR}/uml-run.sh" \
-		"${O}/linux" \
+	TEST_RESULTS="${results}" timeout --signal KILL "${timeout}" </dev/null 2>&1 "${BASE_DIR}/${runner}" \
+		"${kernel}" \
 		-- \
 		"${BASE_DIR}/guest/kselftest.sh" \
 		"${O}/kselftest/kselftest_install/landlock" \
-		| timeout "$((timeout + 1))" cat
+		| timeout "$((timeout + 1))" cat \
+		|| ret=$?
+
+	print_kselftest_results "${results}"
+	return "${ret}"
+}
+
+run_kselftest_uml() {
+	run_kselftest_vm uml-run.sh "${O}/linux" 60
+}
+
+run_kselftest_qemu() {
+	run_kselftest_vm qemu-run.sh "${O}/arch/x86/boot/bzImage" 300
 }
 
 run_kselftest() {
@@ -315,6 +352,9 @@ run_kselftest() {
 		um)
 			run_kselftest_uml
 			;;
+		x86_64)
+			run_kselftest_qemu
+			;;
 		*)
 			echo "ERROR: Architecture not supported" >&2
 			exit 1
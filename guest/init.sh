@@ -13,8 +13,10 @@
 # - TEST_UID
 # - TEST_CWD
 #
-# Optional boot variable:
+# Optional boot variables:
 # - TEST_RET
+# - TEST_RESULTS
+# - TEST_HOSTFS
 
 set -e -u -o pipefail
 
@@ -22,6 +24,35 @@ if [[ -z "${PATH:-}" ]]; then
 	export PATH="/sbin:/bin:/usr/sbin:/usr/bin"
 fi
 
+exit_poweroff() {
+	if [[ -n "${TEST_RET:-}" ]]; then
+		echo "$1" > "${TEST_RET}" || :
+	fi
+	exec poweroff -f
+}
+
+# The init process must never exit (e.g. because of set -e), which would panic
+# the kernel and, with panic=-1, reboot it in a loop.
+unexpected_exit() {
+	echo "ERROR: Unexpected exit of ${BASH_SOURCE[0]}" >&2
+	exit_poweroff 1
+}
+
+trap unexpected_exit EXIT
+
+# Launched as the init process, without systemd, from a root filesystem image
+# (cf. make-rootfs.sh).  Host directories listed in TEST_HOSTFS are mounted at
+# the same location.
+if [[ $$ -eq 1 ]]; then
+	mount -t proc proc /proc
+	mount -t sysfs sysfs /sys
+	IFS=: read -r -a HOSTFS_DIRS <<< "${TEST_HOSTFS:-}"
+	for dir in "${HOSTFS_DIRS[@]}"; do
+		mkdir -p -- "${dir}"
+		mount -t hostfs -o "${dir}" hostfs "${dir}"
+	done
+fi
+
 dmesg --console-level warn
 
 echo 1 > /proc/sys/kernel/panic_on_oops
@@ -30,20 +61,13 @@ echo 1 > /proc/sys/vm/panic_on_oom
 
 echo -1 > /proc/sys/kernel/panic
 
-exit_poweroff() {
-	if [[ -n "${TEST_RET:-}" ]]; then
-		echo "$1" > "${TEST_RET}"
-	fi
-	exec poweroff -f
-}
-
 if [[ -z "${TEST_UID:-}" ]]; then
 	echo "ERROR: This must be launched by uml-run.sh" >&2
 	exit_poweroff 1
 fi
 
-if [[ -z "${INVOCATION_ID:-}" ]]; then
-	echo "ERROR: This must be launched by systemd" >&2
+if [[ -z "${INVOCATION_ID:-}" ]] && [[ $$ -ne 1 ]]; then
+	echo "ERROR: This must be launched by systemd or as the init process" >&2
 	exit_poweroff 1
 fi
 
@@ -94,7 +118,14 @@ else
 	echo "WARNING: Could not find the bindfs command." >&2
 fi
 
-cd "${TEST_CWD}"
+# A root filesystem image may not contain the host working directory (cf.
+# make-rootfs.sh).
+if [[ -d "${TEST_CWD}" ]]; then
+	cd "${TEST_CWD}"
+else
+	echo "WARNING: Could not find ${TEST_CWD}, running from /" >&2
+	cd /
+fi
 
 # Keeps root's capabilities but switches to the current user.
 CAPS="$(setpriv --dump | sed -n -e 's/^Capability bounding set: \(.*\)$/+\1/p' | sed -e 's/,/,+/g')"
@@ -2,17 +2,42 @@
 #
 # Run all tests and exit with an error if any failed.
 #
+# If TEST_RESULTS is set, each test's output is also streamed to
+# TEST_RESULTS/<test>.log, and its result recorded with test-result.sh.
+#
 # Cf. kselftest/kselftest_install/run_kselftest.sh
 
 set -e -u -o pipefail
 
 cd "$1"
 
+log() {
+	if [[ -n "${TEST_RESULTS:-}" ]]; then
+		tee -- "${TEST_RESULTS}/$1.log"
+	else
+		cat
+	fi
+}
+
 while read f; do
 	echo "[+] Running $f:"
-	"./$f"
+	start="$(date +%s.%N)"
+	ret=0
+	"./$f" 2>&1 | log "$f" || ret=$?
+	duration="$(awk -v s="${start}" -v e="$(date +%s.%N)" 'BEGIN { printf("%.3f", e - s) }')"
+
+	if [[ "${ret}" -ne 0 ]]; then
+		test-result.sh "$f" fail "${duration}" "exit ${ret}"
+		test-result.sh bail "$f failed"
+		exit "${ret}"
+	fi
 
 	if dmesg --notime --kernel | grep '^\(BUG\|WARNING\):'; then
+		test-result.sh "$f" fail "${duration}" "kernel warning"
+		test-result.sh bail "kernel warning"
 		exit 1
 	fi
+	test-result.sh "$f" pass "${duration}"
 done < <(ls -1 *_test | sort)
+
+test-result.sh done
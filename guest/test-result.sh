@@ -0,0 +1,89 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>
+#
+# Record a test result in the TEST_RESULTS directory shared with the host, if
+# any, as soon as the test ends:
+# - results.tap: one TAP line per test, with the plan written by "done" once
+#   all the tests ran, or a "Bail out!" line written by "bail" if aborted;
+# - results.jsonl: one JSON object per test.
+#
+# Each record is synced to the host, so that partial results survive a guest
+# killed by a timeout, and the host can follow them live (e.g. tail -f).
+#
+# usage: test-result.sh <name> <pass|fail|skip> <seconds> [detail]
+# usage: test-result.sh done
+# usage: test-result.sh bail [reason]
+
+set -e -u -o pipefail
+
+if [[ -z "${TEST_RESULTS:-}" ]]; then
+	exit 0
+fi
+
+TAP="${TEST_RESULTS}/results.tap"
+JSON="${TEST_RESULTS}/results.jsonl"
+
+count() {
+	grep -c -e '^\(not \)\?ok ' -- "${TAP}" 2>/dev/null || :
+}
+
+if [[ $# -eq 1 ]] && [[ "$1" == "done" ]]; then
+	echo "1..$(count)" >> "${TAP}"
+	sync -- "${TAP}"
+	exit 0
+fi
+
+# Without plan, the results are incomplete.
+if [[ $# -ge 1 ]] && [[ $# -le 2 ]] && [[ "$1" == "bail" ]]; then
+	echo "Bail out!${2:+ $2}" >> "${TAP}"
+	sync -- "${TAP}"
+	exit 0
+fi
+
+if [[ $# -lt 3 ]] || [[ $# -gt 4 ]]; then
+	echo "usage: $(basename -- "${BASH_SOURCE[0]}") <name> <pass|fail|skip> <seconds> [detail] | done | bail [reason]" >&2
+	exit 1
+fi
+
+NAME="$1"
+RESULT="$2"
+DURATION="$3"
+DETAIL="${4:-}"
+
+# Escapes a string for JSON.
+json() {
+	local s="$1"
+
+	s="${s//\\/\\\\}"
+	s="${s//\"/\\\"}"
+	s="${s//$'\t'/\\t}"
+	s="${s//$'\n'/\\n}"
+	printf '"%s"' "${s}"
+}
+
+if [[ ! -s "${TAP}" ]]; then
+	echo "TAP version 13" >> "${TAP}"
+fi
+NUMBER="$(($(count) + 1))"
+
+case "${RESULT}" in
+	pass)
+		echo "ok ${NUMBER} ${NAME}" >> "${TAP}"
+		;;
+	fail)
+		echo "not ok ${NUMBER} ${NAME}${DETAIL:+ # ${DETAIL}}" >> "${TAP}"
+		;;
+	skip)
+		echo "ok ${NUMBER} ${NAME} # SKIP${DETAIL:+ ${DETAIL}}" >> "${TAP}"
+		;;
+	*)
+		echo "ERROR: Unknown result: ${RESULT}" >&2
+		exit 1
+		;;
+esac
+
+echo "{\"test\": $(json "${NAME}"), \"result\": $(json "${RESULT}"), \"seconds\": ${DURATION}, \"detail\": $(json "${DETAIL}")}" >> "${JSON}"
+
+sync -- "${TAP}" "${JSON}"
@@ -0,0 +1,242 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright © 2023-2025 Mickaël Salaün <mic@digikod.net>
+#
+# Build the User-Mode Linux kernels stored in kernels/artifacts.
+#
+# Each version is identified by a kernels/config-<version> file, whose header
+# contains the exact upstream release to check out.  All kernels are built in
+# parallel, sharing the same make jobserver, stored zstd-compressed, and a
+# manifest is written with their provenance, hashes and build times.  Versions
+# whose sources, config and patches didn't change since the last build are
+# skipped.
+#
+# usage: [JOBS=N] [WORK_DIR=dir] make-uml.sh <linux-git-dir> [version]...
+#
+# Examples:
+# ./kernels/make-uml.sh ~/linux
+# ./kernels/make-uml.sh ~/linux 6.1 6.7
+
+set -e -u -o pipefail
+
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+SCRIPT="$(readlink -f -- "${BASH_SOURCE[0]}")"
+KERNELS_DIR="$(dirname -- "${SCRIPT}")"
+ARTIFACTS_DIR="${KERNELS_DIR}/artifacts"
+MANIFEST="${ARTIFACTS_DIR}/manifest"
+
+PATCH_KCONFIG="${KERNELS_DIR}/0001-test-Landlock-with-UML.patch"
+PATCH_SAMPLES="${KERNELS_DIR}/0002-build-sandboxer-with-UML.patch"
+
+# Required for a deterministic Linux kernel.
+export KBUILD_BUILD_USER="root"
+export KBUILD_BUILD_HOST="localhost"
+
+exit_usage() {
+	echo "usage: ${BASENAME} <linux-git-dir> [version]..." >&2
+	exit 1
+}
+
+list_versions() {
+	local config
+
+	for config in "${KERNELS_DIR}"/config-[0-9]*; do
+		echo "${config##*/config-}"
+	done
+}
+
+# Prints the release tag (e.g. v6.1.44) from a configuration header.
+get_tag() {
+	local config="${KERNELS_DIR}/config-$1"
+	local release
+
+	release="$(sed -n -e 's,^# Linux/um \([0-9.]*\) Kernel Configuration$,\1,p' -- "${config}")"
+	if [[ -z "${release}" ]]; then
+		echo "ERROR: No release found in ${config}" >&2
+		return 1
+	fi
+	echo "v${release}"
+}
+
+sha256() {
+	sha256sum -- "$1" | cut -d' ' -f1
+}
+
+# Hashes the decompressed kernel, which doesn't depend on the zstd version.
+sha256_artifact() {
+	zstd --quiet --decompress --stdout -- "$1" | sha256sum | cut -d' ' -f1
+}
+
+# Prints the source identifier of a version: commit, config and patches.
+get_source_id() {
+	local version="$1"
+	local tree="${WORK_DIR}/linux-${version}"
+
+	echo "$(git -C "${tree}" rev-parse HEAD)" \
+		"$(sha256 "${KERNELS_DIR}/config-${version}")" \
+		"$(cat -- "${tree}/.make-uml-patches")"
+}
+
+is_up_to_date() {
+	local version="$1"
+	local name="linux-${version}"
+	local artifact="${ARTIFACTS_DIR}/${name}.zst"
+	local line
+
+	if [[ ! -f "${artifact}" ]] || [[ ! -f "${MANIFEST}" ]]; then
+		return 1
+	fi
+
+	line="$(awk -v name="${name}" '$1 == name { print $3, $4, $5 }' "${MANIFEST}")"
+	[[ "${line}" == "$(get_source_id "${version}")" ]] || return 1
+	[[ "$(awk -v name="${name}" '$1 == name { print $6 }' "${MANIFEST}")" == "$(sha256_artifact "${artifact}")" ]]
+}
+
+# Must be called sequentially: Git worktrees share the same repository.
+prepare_one() {
+	local version="$1"
+	local tag="$(get_tag "${version}")"
+	local tree="${WORK_DIR}/linux-${version}"
+	local patches=""
+
+	echo "[+] Preparing ${tag} in ${tree}"
+	if [[ ! -d "${tree}" ]]; then
+		if ! git -C "${LINUX_DIR}" rev-parse --quiet --verify "${tag}^{commit}" >/dev/null; then
+			git -C "${LINUX_DIR}" fetch --no-tags origin "refs/tags/${tag}:refs/tags/${tag}"
+		fi
+		git -C "${LINUX_DIR}" worktree add --detach "${tree}" "${tag}"
+	else
+		git -C "${tree}" reset --quiet --hard
+		git -C "${tree}" checkout --quiet --detach "${tag}"
+	fi
+
+	# Only applies patches when required (e.g. UML support since Linux 6.5).
+	if git -C "${tree}" apply "${PATCH_KCONFIG}" 2>/dev/null; then
+		patches+="0001"
+	fi
+	if git -C "${tree}" apply "${PATCH_SAMPLES}" 2>/dev/null; then
+		patches+="${patches:+,}0002"
+	fi
+	echo "${patches:--}" > "${tree}/.make-uml-patches"
+}
+
+# Called by the generated makefile, with the jobserver in MAKEFLAGS.
+build_one() {
+	local version="$1"
+	local tree="${WORK_DIR}/linux-${version}"
+	local out="${tree}/.out-make-uml"
+	local start
+
+	start="$(date +%s)"
+	mkdir -p -- "${out}"
+	cp -- "${KERNELS_DIR}/config-${version}" "${out}/.config"
+	rm -f -- "${out}/.version"
+
+	export KBUILD_BUILD_TIMESTAMP="$(git -C "${tree}" log --no-walk --pretty=format:%aD)"
+	make -s -C "${tree}" ARCH=um "O=${out}" olddefconfig
+	make -s -C "${tree}" ARCH=um "O=${out}"
+
+	strip -o "${out}/linux.stripped" -- "${out}/linux"
+	zstd --quiet --force -19 -o "${ARTIFACTS_DIR}/linux-${version}.zst.new" -- "${out}/linux.stripped"
+	mv -- "${ARTIFACTS_DIR}/linux-${version}.zst.new" "${ARTIFACTS_DIR}/linux-${version}.zst"
+	echo "$(($(date +%s) - start))" > "${out}/.make-uml-seconds"
+	echo "[+] Built linux-${version}"
+}
+
+# Runs all builds with a shared jobserver: each recipe is prefixed with "+".
+build_all() {
+	local version
+
+	{
+		echo ".PHONY: all $*"
+		echo "all: $*"
+		for version in "$@"; do
+			echo "${version}:"
+			printf '\t+@"%s" --build-one "%s"\n' "${SCRIPT}" "${version}"
+		done
+	} > "${WORK_DIR}/Makefile"
+
+	make --no-print-directory -f "${WORK_DIR}/Makefile" "-j${JOBS}" all
+}
+
+write_manifest() {
+	local version name tree seconds
+	local tmp="${MANIFEST}.new"
+
+	{
+		echo "# name tag commit config-sha256 patches sha256 build-seconds"
+		for version in $(list_versions); do
+			name="linux-${version}"
+			tree="${WORK_DIR}/linux-${version}"
+			if [[ -d "${tree}" ]] && [[ -f "${tree}/.out-make-uml/.make-uml-seconds" ]]; then
+				seconds="$(< "${tree}/.out-make-uml/.make-uml-seconds")"
+				echo "${name} $(get_tag "${version}") $(get_source_id "${version}")" \
+					"$(sha256_artifact "${ARTIFACTS_DIR}/${name}.zst")" "${seconds}"
+			elif [[ -f "${MANIFEST}" ]]; then
+				# Keeps entries of versions not built on this host.
+				awk -v name="${name}" '$1 == name' "${MANIFEST}"
+			fi
+		done
+	} > "${tmp}"
+	mv -- "${tmp}" "${MANIFEST}"
+}
+
+if [[ "${1:-}" == "--build-one" ]]; then
+	WORK_DIR="$(readlink -f -- "${WORK_DIR}")"
+	build_one "$2"
+	exit 0
+fi
+
+if [[ $# -lt 1 ]]; then
+	exit_usage
+fi
+
+LINUX_DIR="$(readlink -f -- "$1")"
+shift
+
+if [[ -z "$(git -C "${LINUX_DIR}" rev-parse --git-dir 2>/dev/null)" ]]; then
+	echo "ERROR: Not a Git repository: ${LINUX_DIR}" >&2
+	exit 1
+fi
+
+if ! command -v zstd &>/dev/null; then
+	echo "ERROR: Unable to find the \"zstd\" command" >&2
+	exit 1
+fi
+
+if [[ -z "${JOBS:-}" ]]; then
+	JOBS="$(nproc)"
+fi
+
+if [[ -z "${WORK_DIR:-}" ]]; then
+	WORK_DIR="${LINUX_DIR}/.make-uml"
+fi
+mkdir -p -- "${WORK_DIR}"
+export WORK_DIR="$(readlink -f -- "${WORK_DIR}")"
+
+if [[ $# -eq 0 ]]; then
+	set -- $(list_versions)
+fi
+
+TO_BUILD=()
+for version in "$@"; do
+	if [[ ! -f "${KERNELS_DIR}/config-${version}" ]]; then
+		echo "ERROR: Unknown version: ${version}" >&2
+		exit 1
+	fi
+	prepare_one "${version}"
+	if is_up_to_date "${version}"; then
+		echo "[*] Up to date: linux-${version}"
+	else
+		TO_BUILD+=("${version}")
+	fi
+done
+
+if [[ "${#TO_BUILD[@]}" -gt 0 ]]; then
+	echo "[*] Building with ${JOBS} jobs: ${TO_BUILD[*]}"
+	build_all "${TO_BUILD[@]}"
+fi
+
+write_manifest
+echo "[*] Manifest: ${MANIFEST}"
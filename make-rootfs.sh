@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>
+#
+# Build a minimal ext4 root filesystem image for uml-run.sh (cf. ROOTFS), to
+# avoid going through hostfs for every exec, library load and file access in
+# the guest.
+#
+# The image contains bash, the coreutils and util-linux commands used by the
+# guest scripts, this repository's guest directory, the given paths (e.g. the
+# installed selftests and the directory tests are run from), all at the same
+# location as on the host, and the shared libraries they need.  There is no
+# systemd: guest/init.sh runs as the init process.
+#
+# Examples:
+# ./make-rootfs.sh rootfs.ext4 .../kselftest/kselftest_install/landlock
+# ROOTFS=rootfs.ext4 ./uml-run.sh .../linux -- .../guest/kselftest.sh .../kselftest/kselftest_install/landlock
+#
+# Optional environment variable:
+# - ROOTFS_COMMANDS: additional commands to include (space-separated)
+
+set -e -u -o pipefail
+
+if [[ $# -lt 1 ]]; then
+	echo "usage: ${BASH_SOURCE[0]} <image> [path]..." >&2
+	exit 1
+fi
+
+BASE_DIR="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+
+IMAGE="$1"
+shift
+
+# Commands used by guest/init.sh, guest/kselftest.sh and the benchmarks.
+COMMANDS=(
+	awk basename bash cat chmod cp cut date dirname dmesg env false getent
+	grep head id ln ls mkdir mount mv nproc poweroff readlink rm sed seq
+	setpriv sh sleep sort sync tail tee timeout true umount unshare wc
+	${ROOTFS_COMMANDS:-}
+)
+
+if ! command -v mkfs.ext4 &>/dev/null; then
+	echo "ERROR: Unable to find the \"mkfs.ext4\" command" >&2
+	exit 1
+fi
+
+STAGING="$(mktemp --directory)"
+
+cleanup() {
+	rm -rf -- "${STAGING}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+# Copies a file at the same location, following symlinks.
+copy_file() {
+	local path="$1"
+
+	if [[ -e "${STAGING}${path}" ]]; then
+		return
+	fi
+	mkdir -p -- "${STAGING}$(dirname -- "${path}")"
+	cp --dereference -- "${path}" "${STAGING}${path}"
+}
+
+# Copies the shared libraries required by an ELF file, if any.
+copy_libs() {
+	local lib
+
+	while read -r lib; do
+		copy_file "${lib}"
+	done < <(ldd -- "$1" 2>/dev/null | awk '$2 == "=>" && $3 ~ /^\// { print $3 } $1 ~ /^\// { print $1 }')
+}
+
+for cmd in "${COMMANDS[@]}"; do
+	if ! path="$(type -P -- "${cmd}")"; then
+		echo "WARNING: Could not find the ${cmd} command." >&2
+		continue
+	fi
+	copy_file "${path}"
+	copy_libs "${path}"
+done
+
+# Scripts use /usr/bin/env, and /bin/sh may be a symlink.
+copy_file /usr/bin/env
+copy_libs /usr/bin/env
+copy_file /bin/sh
+
+for path in "${BASE_DIR}/guest" "$@"; do
+	path="$(readlink -f -- "${path}")"
+	if [[ ! -e "${path}" ]]; then
+		echo "ERROR: Could not find ${path}" >&2
+		exit 1
+	fi
+	mkdir -p -- "${STAGING}$(dirname -- "${path}")"
+	cp -a -- "${path}" "${STAGING}${path}"
+	while read -r file; do
+		copy_libs "${file}"
+	done < <(find "${path}" -type f -perm -u+x)
+done
+
+# Required by getent and setpriv for the test user.
+for path in /etc/passwd /etc/group; do
+	copy_file "${path}"
+done
+
+for path in /dev /mnt /proc /run /sys /tmp; do
+	mkdir -p -- "${STAGING}${path}"
+done
+
+SIZE_KB="$(du -s -k -- "${STAGING}" | cut -f1)"
+rm -f -- "${IMAGE}"
+truncate --size "$((SIZE_KB + 65536))K" -- "${IMAGE}"
+mkfs.ext4 -q -L rootfs -E root_owner=0:0 -d "${STAGING}" -- "${IMAGE}"
+
+echo "[+] ${IMAGE}: $(du -s -h -- "${STAGING}" | cut -f1) of files"
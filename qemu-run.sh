@@ -0,0 +1,131 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>
+#
+# Launch a minimal multi-core QEMU system to run all Landlock tests, as
+# uml-run.sh does with User-Mode Linux.
+#
+# The kernel must be built with config-mini-x86_64 (e.g. ARCH=x86_64
+# check-linux.sh build).  The host root filesystem is shared with the guest
+# through virtio-9p, and the guest runs the same systemd and guest/init.sh
+# flow as with UML.  KVM is used if available, otherwise TCG.
+#
+# Optional environment variables:
+# - CPUS: number of vCPUs (default: number of host CPUs, up to 16)
+# - MEM: guest memory (default: 1G)
+#
+# Examples:
+# ./qemu-run.sh .../arch/x86/boot/bzImage HISTFILE=/dev/null -- bash -i
+# CPUS=4 ./qemu-run.sh .../bzImage -- .../tools/testing/selftests/kselftest_install/run_kselftest.sh
+
+set -e -u -o pipefail
+
+if [[ $# -lt 2 ]]; then
+	echo "usage: ${BASH_SOURCE[0]} <linux-x86_64-kernel> [VAR=value]... -- <exec-path> [exec-arg]..." >&2
+	exit 1
+fi
+
+BASE_DIR="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+
+KERNEL="$1"
+shift
+
+has_double_dash() {
+	local arg
+
+	for arg in "$@"; do
+		if [[ "${arg}" == "--" ]]; then
+			return 0
+		fi
+	done
+	return 1
+}
+
+if ! has_double_dash "$@"; then
+	echo "ERROR: Missing '--' argument" >&2
+	exit 1
+fi
+
+if ! command -v qemu-system-x86_64 &>/dev/null; then
+	echo "ERROR: Unable to find the \"qemu-system-x86_64\" command" >&2
+	exit 1
+fi
+
+# Handles relative file without "./" prefix.
+KERNEL="$(readlink -f -- "${KERNEL}")"
+
+if [[ ! -f "${KERNEL}" ]]; then
+	echo "ERROR: Could not find this kernel: ${KERNEL}" >&2
+	exit 1
+fi
+
+# The guest mounts a tmpfs on /tmp, which would hide the returned value.
+KERNEL_DIR="$(dirname -- "${KERNEL}")/"
+if [[ "${KERNEL_DIR}" =~ ^/(tmp|run)/ ]]; then
+	echo "ERROR: The kernel must not be in /tmp nor /run: ${KERNEL_DIR}" >&2
+	exit 1
+fi
+
+CPUS="${CPUS:-$(nproc)}"
+if [[ "${CPUS}" -gt 16 ]]; then
+	# Cf. CONFIG_NR_CPUS in config-mini-x86_64
+	CPUS=16
+fi
+
+if [[ -r /dev/kvm ]] && [[ -w /dev/kvm ]]; then
+	ACCEL=(-accel kvm -cpu host)
+	ACCEL_NAME="KVM"
+else
+	ACCEL=(-accel tcg -cpu max)
+	ACCEL_NAME="TCG"
+fi
+
+# Optional directory shared with the guest to stream test results (cf.
+# guest/test-result.sh).
+RESULTS_ARG=()
+if [[ -n "${TEST_RESULTS:-}" ]]; then
+	mkdir -p -- "${TEST_RESULTS}"
+	TEST_RESULTS="$(readlink -f -- "${TEST_RESULTS}")"
+	if [[ "${TEST_RESULTS}/" =~ ^/(tmp|run)/ ]]; then
+		echo "ERROR: The results directory must not be in /tmp nor /run: ${TEST_RESULTS}" >&2
+		exit 1
+	fi
+	RESULTS_ARG=("TEST_RESULTS=${TEST_RESULTS}")
+fi
+
+OUT_RET="$(mktemp "--tmpdir=${KERNEL_DIR}" .qemu-run-ret.XXXXXXXXXX)"
+
+cleanup() {
+	rm -- "${OUT_RET}"
+}
+
+trap cleanup QUIT INT TERM EXIT
+
+echo "[*] Booting kernel ${KERNEL} with ${CPUS} vCPUs (${ACCEL_NAME})"
+
+qemu-system-x86_64 \
+	"${ACCEL[@]}" \
+	-smp "${CPUS}" \
+	-m "${MEM:-1G}" \
+	-nographic \
+	-no-reboot \
+	-fsdev "local,id=root,path=/,security_model=none,multidevs=remap" \
+	-device "virtio-9p-pci,fsdev=root,mount_tag=/dev/root" \
+	-kernel "${KERNEL}" \
+	-append "rootfstype=9p \
+rootflags=trans=virtio,version=9p2000.L,cache=loose \
+root=/dev/root \
+rw \
+console=ttyS0 \
+quiet \
+SYSTEMD_UNIT_PATH=${BASE_DIR}/guest/systemd \
+PATH=${BASE_DIR}/guest:${PATH:-/usr/bin} \
+TERM=${TERM:-linux} \
+TEST_UID=$(id -u) \
+TEST_CWD=$(pwd) \
+TEST_RET=${OUT_RET} \
+${RESULTS_ARG[*]} \
+$*"
+
+exit "$(< "${OUT_RET}")"
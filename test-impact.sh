@@ -0,0 +1,465 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Copyright © 2025 Mickaël Salaün <mic@digikod.net>
+#
+# Select the Landlock selftests impacted by a patch, according to the kernel
+# code coverage (GCOV) of each test case.
+#
+# The map command boots a coverage kernel (config-mini-x86_64 enables
+# GCOV_KERNEL and GCOV_PROFILE_ALL) with qemu-run.sh, runs each selftest case
+# once, and maps it to the security/landlock lines it covers.  The select
+# command then prints the test cases covering lines changed by a diff.
+#
+# Test cases can be split across shards (e.g. SHARD=2/4) to map them in
+# parallel, and the resulting maps merged.
+#
+# cd linux
+# ARCH=x86_64 .../check-linux.sh build build_kselftest
+# .../test-impact.sh map .../landlock.map
+# git diff -U0 HEAD~ | .../test-impact.sh select .../landlock.map
+#
+# Commands:
+# - map <map>: create a map for the current build (O and TESTS_DIR)
+# - select <map> [diff]: print the test cases impacted by a diff (default:
+#   stdin), as <test>:<case> lines
+# - merge <map>...: merge maps from shards
+# - report <map>: print the number of lines covered per file
+#
+# Selected test cases can be run with:
+# ./fs_test -r layout1.inherit_superset
+
+set -e -u -o pipefail
+
+BASE_DIR="$(dirname -- "$(readlink -f -- "${BASH_SOURCE[0]}")")"
+BASENAME="$(basename -- "${BASH_SOURCE[0]}")"
+
+usage() {
+	echo "usage: ${BASENAME} map <map> | select <map> [diff] | merge <map>... | report <map>" >&2
+	exit 1
+}
+
+# Prints the test cases of a selftest, as accepted by its -r option, from the
+# kselftest harness listing.  Each fixture block lists its name, variants and
+# tests in fixed-width columns, and its test cases are all the combinations of
+# variants and tests:
+#
+# # FIXTURE            VARIANT                   TEST
+# layout1                                        inherit_superset
+#                                                proc_nsfs
+# --------------------------------------------------------------------------------
+# ioctl                handled_i_allowed_none    handle_dir_access_file
+#                      handled_i_allowed_i       handle_file_access_file
+list_cases() {
+	local test="$1"
+
+	"./${test}" -l 2>&1 | awk '
+	function flush(    i, j) {
+		if (fixture == "") {
+			return
+		}
+		if (!nb_variants) {
+			variants[++nb_variants] = ""
+		}
+		for (i = 1; i <= nb_variants; i++) {
+			for (j = 1; j <= nb_tests; j++) {
+				print fixture (variants[i] == "" ? "" : "." variants[i]) "." tests[j]
+			}
+		}
+		fixture = ""
+		nb_variants = nb_tests = 0
+	}
+
+	/^# FIXTURE/ || /^---/ {
+		flush()
+		first = 1
+		next
+	}
+
+	# The fixture name may overflow its column.
+	first {
+		first = 0
+		fixture = $1
+		if (NF == 3) {
+			variants[++nb_variants] = $2
+			tests[++nb_tests] = $3
+		} else if (NF == 2) {
+			tests[++nb_tests] = $2
+		}
+		next
+	}
+
+	# Without fixture name, the columns start at fixed offsets.
+	NF == 2 {
+		variants[++nb_variants] = $1
+		tests[++nb_tests] = $2
+	}
+
+	NF == 1 {
+		if (match($0, /[^ ]/) < 48) {
+			variants[++nb_variants] = $1
+		} else {
+			tests[++nb_tests] = $1
+		}
+	}
+
+	END {
+		flush()
+	}'
+}
+
+# Runs inside the guest: runs each test case of the shard after resetting the
+# coverage counters, and copies the Landlock ones to the output directory.
+run_guest() {
+	local tests_dir="$1"
+	local out="$2"
+	local shard_index="${3%/*}"
+	local shard_count="${3#*/}"
+	local gcov_dir="/sys/kernel/debug/gcov"
+	local index=0
+	local test name dir gcda
+
+	# The guest init does not mount debugfs.
+	if ! mountpoint -q /sys/kernel/debug; then
+		mount -t debugfs none /sys/kernel/debug || :
+	fi
+	if [[ ! -d "${gcov_dir}" ]]; then
+		echo "ERROR: No GCOV support, see CONFIG_DEBUG_FS and CONFIG_GCOV_KERNEL" >&2
+		return 1
+	fi
+
+	cd "${tests_dir}"
+	for test in $(ls -1 *_test | sort); do
+		while read -r name; do
+			index="$((index + 1))"
+			if [[ "$(((index - 1) % shard_count))" -ne "$((shard_index - 1))" ]]; then
+				continue
+			fi
+
+			echo 1 > "${gcov_dir}/reset"
+			"./${test}" -r "${name}" &>/dev/null || :
+
+			dir="${out}/${test}/${name}"
+			mkdir -p -- "${dir}"
+			while read -r gcda; do
+				# Debugfs files have no size, so cp may copy nothing.
+				cat -- "${gcda}" > "${dir}/$(basename -- "${gcda}")"
+			done < <(find "${gcov_dir}" -path '*/security/landlock/*.gcda')
+			echo "[impact] ${test}:${name}"
+		done < <(list_cases "${test}")
+	done
+}
+
+# Converts the coverage data of each test case to map lines: test case, source
+# file, and ranges of covered lines.  Test cases without covered lines get a
+# line with "-" as file, but all of them must have coverage data.
+build_map() {
+	local out="$1"
+	local dir test_case gcda src
+
+	for dir in "${out}"/*/*/; do
+		if [[ ! -d "${dir}" ]]; then
+			echo "ERROR: No test case mapped" >&2
+			return 1
+		fi
+		test_case="$(basename -- "$(dirname -- "${dir}")"):$(basename -- "${dir}")"
+		printf '%s\t-\t-\n' "${test_case}"
+		for gcda in "${dir}"*.gcda; do
+			if [[ ! -f "${gcda}" ]]; then
+				echo "ERROR: No coverage data for ${test_case}" >&2
+				return 1
+			fi
+			src="security/landlock/$(basename -- "${gcda}" .gcda).c"
+			cp -- "${O}/${src%.c}.gcno" "${dir}"
+			gcov --stdout --object-directory "${dir}" -- "${src}" 2>/dev/null \
+				| awk -F: -v test_case="${test_case}" -v src="${src}" '
+				function flush() {
+					if (first != "") {
+						ranges = ranges "," (first == last ? first : first "-" last)
+					}
+				}
+
+				{
+					count = $1
+					gsub(/[ *]/, "", count)
+					line = $2 + 0
+				}
+
+				line > 0 && count ~ /^[0-9]+$/ && count > 0 {
+					if (first != "" && line == last + 1) {
+						last = line
+						next
+					}
+					flush()
+					first = last = line
+				}
+
+				END {
+					flush()
+					if (ranges != "") {
+						printf("%s\t%s\t%s\n", test_case, src, substr(ranges, 2))
+					}
+				}'
+		done
+	done
+}
+
+# Output directory of the guest, removed when the script exits.
+MAP_OUT=""
+
+cleanup() {
+	if [[ -n "${MAP_OUT}" ]]; then
+		rm -rf -- "${MAP_OUT}"
+	fi
+}
+
+map() {
+	local map="$1"
+	local shard="${SHARD:-1/1}"
+	local ret=0
+
+	if [[ ! "${shard}" =~ ^[0-9]+/[0-9]+$ ]] || [[ "${shard%/*}" -lt 1 ]] || [[ "${shard%/*}" -gt "${shard#*/}" ]]; then
+		echo "ERROR: Invalid shard: ${shard}" >&2
+		exit 1
+	fi
+
+	export O="${O:-./.out-landlock_local-x86_64-gcc}"
+	TESTS_DIR="$(readlink -f -- "${TESTS_DIR:-${O}/kselftest/kselftest_install/landlock}")"
+	if [[ ! -d "${TESTS_DIR}" ]]; then
+		echo "ERROR: No selftests found, see TESTS_DIR: ${TESTS_DIR}" >&2
+		exit 1
+	fi
+
+	# The guest mounts a tmpfs on /tmp (cf. qemu-run.sh).
+	trap cleanup QUIT INT TERM EXIT
+	MAP_OUT="$(mktemp --directory "--tmpdir=${O}" .test-impact.XXXXXXXXXX)"
+	MAP_OUT="$(readlink -f -- "${MAP_OUT}")"
+
+	echo "[*] Mapping test cases of shard ${shard}"
+	"${BASE_DIR}/qemu-run.sh" \
+		"${O}/arch/x86/boot/bzImage" \
+		-- \
+		"${BASE_DIR}/${BASENAME}" --guest "${TESTS_DIR}" "${MAP_OUT}" "${shard}" \
+		</dev/null 2>&1 \
+		| { grep '^\[impact\] \|^ERROR: ' || :; } \
+		|| ret=$?
+	if [[ "${ret}" -ne 0 ]]; then
+		echo "ERROR: Failed to map the test cases (exit code ${ret})" >&2
+		exit 1
+	fi
+
+	if ! build_map "${MAP_OUT}" | sort > "${map}.tmp"; then
+		rm -f -- "${map}.tmp"
+		exit 1
+	fi
+	mv -- "${map}.tmp" "${map}"
+	echo "[+] ${map}: $(cut -f1 -- "${map}" | sort -u | wc -l) test cases"
+}
+
+# Prints the test cases covering the old lines of each diff hunk.  Pure
+# additions are matched with the lines around them.  Hunks not touching any
+# covered line (e.g. declarations) select all the test cases covering their
+# file.  Changes to Landlock files without coverage data (e.g. headers,
+# selftests helpers) select all the test cases, or all the ones of a selftest
+# for its own source file.
+select_tests() {
+	local map="$1"
+	local diff="${2:--}"
+
+	awk -F '\t' '
+	function is_landlock(file) {
+		return file ~ /^(security\/landlock|tools\/testing\/selftests\/landlock)\// || file == "include/uapi/linux/landlock.h"
+	}
+
+	# Selftest name of a source file.
+	function test_name(file) {
+		sub(/^.*\//, "", file)
+		sub(/\.c$/, "", file)
+		return file
+	}
+
+	function select_all(prefix,    t) {
+		for (t in all) {
+			if (prefix == "" || index(t, prefix ":") == 1) {
+				selected[t] = 1
+			}
+		}
+	}
+
+	FILENAME == ARGV[1] {
+		all[$1] = 1
+		if ($2 != "-") {
+			covered_file[$2] = 1
+			rows++
+			row_test[rows] = $1
+			row_file[rows] = $2
+			row_ranges[rows] = $3
+		}
+		next
+	}
+
+	# Diff lines are not tab-separated.
+	{
+		split($0, f, " ")
+	}
+
+	/^--- / {
+		file = substr(f[2], 3)
+		if (f[2] == "/dev/null") {
+			file = ""
+		}
+		next
+	}
+
+	/^\+\+\+ / {
+		if (file == "") {
+			file = substr(f[2], 3)
+		}
+		if (!(file in seen)) {
+			seen[file] = 1
+			files[++nb_files] = file
+		}
+		next
+	}
+
+	/^@@ / {
+		split(substr(f[2], 2), old, ",")
+		first = old[1] + 0
+		count = (2 in old) ? old[2] + 0 : 1
+		nb_hunks++
+		hunk_file[nb_hunks] = file
+		hunk_first[nb_hunks] = first
+		# Pure additions are matched with the lines before and after.
+		hunk_last[nb_hunks] = count ? first + count - 1 : first + 1
+	}
+
+	END {
+		for (i = 1; i <= nb_files; i++) {
+			file = files[i]
+			if (file in covered_file) {
+				continue
+			}
+			if (!is_landlock(file)) {
+				printf("[*] Ignoring %s\n", file) > "/dev/stderr"
+			} else if (file ~ /^tools\/testing\/selftests\/landlock\/[^\/]*_test\.c$/) {
+				printf("[*] Selecting all %s cases for %s\n", test_name(file), file) > "/dev/stderr"
+				select_all(test_name(file))
+			} else {
+				printf("[*] Selecting all cases for %s\n", file) > "/dev/stderr"
+				select_all("")
+			}
+		}
+
+		for (h = 1; h <= nb_hunks; h++) {
+			if (!(hunk_file[h] in covered_file)) {
+				continue
+			}
+			hit = 0
+			for (r = 1; r <= rows; r++) {
+				if (row_file[r] != hunk_file[h] || (hit && row_test[r] in selected)) {
+					continue
+				}
+				n = split(row_ranges[r], ranges, ",")
+				for (i = 1; i <= n; i++) {
+					if (split(ranges[i], bounds, "-") == 1) {
+						bounds[2] = bounds[1]
+					}
+					if (bounds[1] + 0 <= hunk_last[h] && bounds[2] + 0 >= hunk_first[h]) {
+						selected[row_test[r]] = 1
+						hit = 1
+						break
+					}
+				}
+			}
+			if (!hit) {
+				printf("WARNING: No covered line changed in %s:%d-%d, selecting all cases covering it\n", hunk_file[h], hunk_first[h], hunk_last[h]) > "/dev/stderr"
+				for (r = 1; r <= rows; r++) {
+					if (row_file[r] == hunk_file[h]) {
+						selected[row_test[r]] = 1
+					}
+				}
+			}
+		}
+
+		total = nb_selected = 0
+		for (t in all) {
+			total++
+			if (t in selected) {
+				nb_selected++
+				print t | "sort"
+			}
+		}
+		close("sort")
+		printf("[*] Selected %d of %d test cases\n", nb_selected, total) > "/dev/stderr"
+	}
+' "${map}" "${diff}"
+}
+
+# Prints the number of lines covered by all the test cases, per file.
+report() {
+	local map="$1"
+
+	awk -F '\t' '
+	$2 != "-" {
+		tests[$2]++
+		n = split($3, ranges, ",")
+		for (i = 1; i <= n; i++) {
+			if (split(ranges[i], bounds, "-") == 1) {
+				bounds[2] = bounds[1]
+			}
+			for (l = bounds[1] + 0; l <= bounds[2] + 0; l++) {
+				if (!(($2, l) in covered)) {
+					covered[$2, l] = 1
+					lines[$2]++
+				}
+			}
+		}
+	}
+
+	END {
+		printf("%-40s %8s %8s\n", "file", "lines", "cases")
+		for (file in lines) {
+			printf("%-40s %8d %8d\n", file, lines[file], tests[file]) | "sort"
+		}
+	}' "${map}"
+}
+
+if [[ "${1:-}" == "--guest" ]]; then
+	shift
+	run_guest "$@"
+	exit 0
+fi
+
+if [[ $# -lt 1 ]]; then
+	usage
+fi
+
+case "$1" in
+	map)
+		if [[ $# -ne 2 ]]; then
+			usage
+		fi
+		map "$2"
+		;;
+	select)
+		if [[ $# -lt 2 ]] || [[ $# -gt 3 ]]; then
+			usage
+		fi
+		select_tests "${@:2}"
+		;;
+	merge)
+		if [[ $# -lt 2 ]]; then
+			usage
+		fi
+		sort -u -- "${@:2}"
+		;;
+	report)
+		if [[ $# -ne 2 ]]; then
+			usage
+		fi
+		report "$2"
+		;;
+	*)
+		usage
+		;;
+esac
@@ -5,6 +5,19 @@
 #
 # Launch a minimal User-Mode Linux system to run all Landlock tests.
 #
+# The guest root is the host one through hostfs, unless ROOTFS is set to an
+# image built with make-rootfs.sh (requires CONFIG_BLK_DEV_UBD and
+# CONFIG_EXT4_FS).
+#
+# Optional environment variables:
+# - MEM: guest memory (default: 256M)
+# - MEM_DIR: directory of the guest memory file (default: TMPDIR or /tmp)
+# - ROOTFS: root filesystem image
+# - TEST_RESULTS: directory to stream test results to
+#
+# The peak RSS of the guest is printed at the end, and saved in TEST_RESULTS
+# if set.
+#
 # Examples:
 # ./uml-run.sh linux-6.1 HISTFILE=/dev/null -- bash -i
 # ./uml-run.sh .../linux -- .../tools/testing/selftests/kselftest_install/run_kselftest.sh
@@ -37,10 +50,40 @@ if ! has_double_dash "$@"; then
 	exit 1
 fi
 
+# Decompresses a kernel artifact, once, into a cache directory keyed by the
+# hash of the compressed file, and prints the path of the decompressed kernel.
+get_cached_kernel() {
+	local artifact="$1"
+	local name="$(basename -- "${artifact%.zst}")"
+	local cache_dir="${XDG_CACHE_HOME:-${HOME}/.cache}/landlock-test-tools/kernels"
+	local hash cached tmp
+
+	if ! command -v zstd &>/dev/null; then
+		echo "ERROR: Unable to find the \"zstd\" command" >&2
+		return 1
+	fi
+
+	hash="$(sha256sum -- "${artifact}" | cut -d' ' -f1)"
+	cached="${cache_dir}/${hash}/${name}"
+	if [[ ! -x "${cached}" ]]; then
+		mkdir -p -- "${cache_dir}/${hash}"
+		# Atomically replaced to handle concurrent launches.
+		tmp="$(mktemp "--tmpdir=${cache_dir}/${hash}" ".${name}.XXXXXXXXXX")"
+		zstd --quiet --decompress --force --stdout -- "${artifact}" > "${tmp}"
+		chmod 0755 -- "${tmp}"
+		mv -- "${tmp}" "${cached}"
+	fi
+	echo "${cached}"
+}
+
 # Looks first for a known kernel.
 KERNEL_ARTIFACT="${BASE_DIR}/kernels/artifacts/${KERNEL}"
-if [[ "${KERNEL}" == "$(basename -- "${KERNEL}")" ]] && [[ -f "${KERNEL_ARTIFACT}" ]]; then
-	KERNEL="${KERNEL_ARTIFACT}"
+if [[ "${KERNEL}" == "$(basename -- "${KERNEL}")" ]]; then
+	if [[ -f "${KERNEL_ARTIFACT}" ]]; then
+		KERNEL="${KERNEL_ARTIFACT}"
+	elif [[ -f "${KERNEL_ARTIFACT}.zst" ]]; then
+		KERNEL="$(get_cached_kernel "${KERNEL_ARTIFACT}.zst")"
+	fi
 fi
 
 # Handles relative file without "./" prefix.
@@ -57,30 +100,121 @@ if [[ "${KERNEL_DIR}" =~ ^/(tmp|run)/ ]]; then
 	exit 1
 fi
 
-OUT_RET="$(mktemp "--tmpdir=${KERNEL_DIR}" .uml-run-ret.XXXXXXXXXX)"
+# The guest memory is backed by a file created in MEM_DIR, which should be on a
+# RAM-based filesystem (e.g. /dev/shm) to not hit the disk on page faults.
+MEM="${MEM:-256M}"
+MEM_DIR="${MEM_DIR:-${TMPDIR:-/tmp}}"
+if [[ ! -d "${MEM_DIR}" ]] || [[ ! -w "${MEM_DIR}" ]]; then
+	echo "ERROR: The memory directory must be a writable directory: ${MEM_DIR}" >&2
+	exit 1
+fi
+
+# Optional directory shared with the guest to stream test results (cf.
+# guest/test-result.sh).
+RESULTS_ARG=()
+if [[ -n "${TEST_RESULTS:-}" ]]; then
+	mkdir -p -- "${TEST_RESULTS}"
+	TEST_RESULTS="$(readlink -f -- "${TEST_RESULTS}")"
+	if [[ "${TEST_RESULTS}/" =~ ^/(tmp|run)/ ]]; then
+		echo "ERROR: The results directory must not be in /tmp nor /run: ${TEST_RESULTS}" >&2
+		exit 1
+	fi
+	RESULTS_ARG=("TEST_RESULTS=${TEST_RESULTS}")
+fi
+
+if [[ -z "${ROOTFS:-}" ]]; then
+	OUT_RET="$(mktemp "--tmpdir=${KERNEL_DIR}" .uml-run-ret.XXXXXXXXXX)"
+	ROOT_ARGS=(
+		"rootfstype=hostfs"
+		"rootflags=/"
+		"root=98:0"
+		"SYSTEMD_UNIT_PATH=${BASE_DIR}/guest/systemd"
+	)
+else
+	# Boots from a root filesystem image (cf. make-rootfs.sh), left unchanged
+	# thanks to a copy-on-write file, with guest/init.sh as init process.
+	# Only the directories of the returned value and the results are shared
+	# through hostfs.
+	if [[ ! -f "${ROOTFS}" ]]; then
+		echo "ERROR: Could not find this root filesystem image: ${ROOTFS}" >&2
+		exit 1
+	fi
+	OUT_DIR="$(mktemp --directory "--tmpdir=${KERNEL_DIR}" .uml-run-ret.XXXXXXXXXX)"
+	OUT_RET="${OUT_DIR}/ret"
+	touch -- "${OUT_RET}"
+	ROOT_ARGS=(
+		"ubd0=${OUT_DIR}.cow,$(readlink -f -- "${ROOTFS}")"
+		"root=/dev/ubda"
+		"rootfstype=ext4"
+		"init=${BASE_DIR}/guest/init.sh"
+		"TEST_HOSTFS=${OUT_DIR}${TEST_RESULTS:+:${TEST_RESULTS}}"
+	)
+fi
+
+OUT_RSS="$(mktemp)"
+KERNEL_PID=""
 
 cleanup() {
-	rm -- "${OUT_RET}"
+	if [[ -n "${KERNEL_PID}" ]]; then
+		kill -KILL "${KERNEL_PID}" 2>/dev/null || :
+	fi
+	rm -- "${OUT_RSS}"
+	if [[ -n "${ROOTFS:-}" ]]; then
+		rm -rf -- "${OUT_DIR}" "${OUT_DIR}.cow"
+	else
+		rm -- "${OUT_RET}"
+	fi
 }
 
 trap cleanup QUIT INT TERM EXIT
 
-echo "[*] Booting kernel ${KERNEL}"
+# Records the peak RSS of the main UML process, which maps the guest memory.
+watch_rss() {
+	local pid="$1"
+	local out="$2"
+	local hwm
+
+	while hwm="$(sed -n -e 's/^VmHWM:\s*\([0-9]*\) kB$/\1/p' "/proc/${pid}/status" 2>/dev/null)" && [[ -n "${hwm}" ]]; do
+		echo "${hwm}" > "${out}"
+		sleep 0.2
+	done
+}
 
-"${KERNEL}" \
-	"rootfstype=hostfs" \
-	"rootflags=/" \
-	"root=98:0" \
+echo "[*] Booting kernel ${KERNEL} with ${MEM} of memory backed in ${MEM_DIR}"
+
+# Keeps the standard input of the console.  UML creates its memory file in the
+# first directory set in TMP, TEMP or TMPDIR.
+TMP="${MEM_DIR}" TEMP="${MEM_DIR}" TMPDIR="${MEM_DIR}" "${KERNEL}" \
+	"${ROOT_ARGS[@]}" \
 	"rw" \
 	"console=tty0" \
-	"mem=256M" \
+	"mem=${MEM}" \
 	"quiet" \
-	"SYSTEMD_UNIT_PATH=${BASE_DIR}/guest/systemd" \
 	"PATH=${BASE_DIR}/guest:${PATH:-/usr/bin}" \
 	"TERM=${TERM:-linux}" \
 	"TEST_UID=$(id -u)" \
 	"TEST_CWD=$(pwd)" \
 	"TEST_RET=${OUT_RET}" \
-	$*
+	"${RESULTS_ARG[@]}" \
+	$* \
+	<&0 &
+KERNEL_PID=$!
+
+watch_rss "${KERNEL_PID}" "${OUT_RSS}" &
+wait "${KERNEL_PID}"
+KERNEL_PID=""
+wait
+
+if [[ -s "${OUT_RSS}" ]]; then
+	echo "[*] Peak RSS: $(($(< "${OUT_RSS}") / 1024)) MiB"
+	if [[ -n "${TEST_RESULTS:-}" ]]; then
+		cp -- "${OUT_RSS}" "${TEST_RESULTS}/peak-rss-kb"
+	fi
+fi
 
-exit "$(< "${OUT_RET}")"
+RET="$(< "${OUT_RET}")"
+if [[ ! "${RET}" =~ ^[0-9]+$ ]]; then
+	echo "ERROR: The guest did not return any value" >&2
+	exit 1
+fi
+exit "${RET}"